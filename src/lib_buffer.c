@@ -0,0 +1,290 @@
+/*
+** Buffer library.
+** Copyright (C) 2005-2020 Mike Pall. See Copyright Notice in luajit.h
+*/
+
+#define lib_buffer_c
+#define LUA_LIB
+
+#include "lua.h"
+#include "lauxlib.h"
+#include "lualib.h"
+
+#include "lj_obj.h"
+#include "lj_gc.h"
+#include "lj_err.h"
+#include "lj_buf.h"
+#include "lj_str.h"
+#include "lj_meta.h"
+#include "lj_state.h"
+#include "lj_frame.h"
+#include "lj_vm.h"
+#if LJ_HASFFI
+#include "lj_ctype.h"
+#include "lj_cdata.h"
+#endif
+#include "lj_strfmt.h"
+#include "lj_serialize.h"
+#include "lj_ff.h"
+#include "lj_lib.h"
+
+/* -- Helper functions ---------------------------------------------------- */
+
+/* Check argument 1 for a buffer object and set its lua_State. */
+static SBufExt *buffer_tobuf(lua_State *L)
+{
+  SBufExt *sbx;
+  if (!(L->base < L->top && tvisudata(L->base) &&
+	udataV(L->base)->udtype == UDTYPE_BUFFER))
+    lj_err_argtype(L, 1, "buffer");
+  sbx = (SBufExt *)uddata(udataV(L->base));
+  setsbufL(&sbx->sb, L);
+  return sbx;
+}
+
+/* Return the buffer object itself to allow chaining of method calls. */
+static int buffer_ret(lua_State *L)
+{
+  L->top = L->base+1;
+  return 1;
+}
+
+/* Check optional length argument, defaulting to the whole buffer. */
+static MSize buffer_checklen(lua_State *L, SBufExt *sbx, int arg)
+{
+  MSize len = sbufxlen(sbx);
+  TValue *o = L->base+arg-1;
+  if (o < L->top && !tvisnil(o)) {
+    int32_t n = lj_lib_checkint(L, arg);
+    if (n < 0) n = 0;
+    if ((MSize)n < len) len = (MSize)n;
+  }
+  return len;
+}
+
+/* -- Buffer methods ------------------------------------------------------ */
+
+#define LJLIB_MODULE_buffer_method
+
+LJLIB_CF(buffer_method_put)		LJLIB_REC(buffer_put)
+{
+  SBufExt *sbx = buffer_tobuf(L);
+  TValue *o;
+  int arg = 2;
+  for (o = L->base+1; o < L->top; o++, arg++) {
+    if (tvisstr(o)) {
+      lj_bufx_putstr(L, sbx, strV(o));
+    } else if (tvisint(o)) {
+      lj_bufx_putint(L, sbx, intV(o));
+    } else if (tvisnum(o)) {
+      lj_bufx_putnum(L, sbx, numV(o));
+    } else if (tvisudata(o) && udataV(o)->udtype == UDTYPE_BUFFER) {
+      SBufExt *sbx2 = (SBufExt *)uddata(udataV(o));
+      MSize len = sbufxlen(sbx2);
+      char *p = lj_bufx_more(sbx, len);  /* May be the same buffer. */
+      memcpy(p, sbufxR(sbx2), len);
+      setsbufP(&sbx->sb, p + len);
+    } else {
+      cTValue *mo = lj_meta_lookup(L, o, MM_tostring);
+      if (tvisnil(mo))
+	lj_err_argt(L, arg, LUA_TSTRING);
+      copyTV(L, L->top++, mo);
+      copyTV(L, L->top++, o);
+      lua_call(L, 1, 1);
+      o = L->base+arg-1;  /* Stack may have been reallocated. */
+      if (!tvisstr(L->top-1))
+	lj_err_argt(L, arg, LUA_TSTRING);
+      L->top--;
+      lj_bufx_putstr(L, sbx, strV(L->top));
+    }
+  }
+  return buffer_ret(L);
+}
+
+LJLIB_CF(buffer_method_putf)
+{
+  SBufExt *sbx = buffer_tobuf(L);
+  lj_strfmt_putarg(L, &sbx->sb, 2, 1);
+  return buffer_ret(L);
+}
+
+static TValue *buffer_encode_cp(lua_State *L, lua_CFunction dummy, void *ud)
+{
+  UNUSED(dummy);
+  cframe_errfunc(L->cframe) = -1;  /* Inherit error function. */
+  lj_serialize_put((SBuf *)ud, L->base+1);
+  return NULL;
+}
+
+LJLIB_CF(buffer_method_encode)
+{
+  SBufExt *sbx = buffer_tobuf(L);
+  MSize len = sbuflen(&sbx->sb);
+  int errcode;
+  lj_lib_checkany(L, 2);
+  errcode = lj_vm_cpcall(L, NULL, &sbx->sb, buffer_encode_cp);
+  if (errcode) {  /* Drop partially encoded data and propagate errors. */
+    setsbufP(&sbx->sb, sbufB(&sbx->sb) + len);
+    lj_err_throw(L, errcode);
+  }
+  lj_gc_check(L);
+  return buffer_ret(L);
+}
+
+LJLIB_CF(buffer_method_decode)
+{
+  SBufExt *sbx = buffer_tobuf(L);
+  const char *r;
+  setnilV(L->top++);
+  r = lj_serialize_get(L, sbufxR(sbx), sbufP(&sbx->sb), L->top-1);
+  sbx->r = (MSize)(r - sbufB(&sbx->sb));
+  lj_bufx_rewind(sbx);
+  lj_gc_check(L);
+  return 1;
+}
+
+LJLIB_CF(buffer_method_get)
+{
+  SBufExt *sbx = buffer_tobuf(L);
+  int arg, narg = (int)(L->top - L->base);
+  if (narg == 1) {  /* get() is the same as get(nil). */
+    setnilV(L->top++);
+    narg++;
+  }
+  for (arg = 2; arg <= narg; arg++) {
+    MSize len = buffer_checklen(L, sbx, arg);
+    setstrV(L, L->base+arg-1, lj_str_new(L, sbufxR(sbx), len));
+    sbx->r += len;
+  }
+  lj_bufx_rewind(sbx);
+  lj_gc_check(L);
+  return narg-1;
+}
+
+LJLIB_CF(buffer_method_skip)
+{
+  SBufExt *sbx = buffer_tobuf(L);
+  sbx->r += buffer_checklen(L, sbx, 2);
+  lj_bufx_rewind(sbx);
+  return buffer_ret(L);
+}
+
+LJLIB_CF(buffer_method_reset)		LJLIB_REC(buffer_reset)
+{
+  lj_bufx_reset(buffer_tobuf(L));
+  return buffer_ret(L);
+}
+
+LJLIB_CF(buffer_method_free)
+{
+  SBufExt *sbx = buffer_tobuf(L);
+  lj_buf_free(G(L), &sbx->sb);
+  lj_bufx_init(L, sbx);
+  return buffer_ret(L);
+}
+
+#if LJ_HASFFI
+LJLIB_CF(buffer_method_reserve)
+{
+  SBufExt *sbx = buffer_tobuf(L);
+  int32_t sz = lj_lib_checkint(L, 2);
+  CTState *cts;
+  CTypeID id;
+  GCcdata *cd;
+  if (sz < 0) lj_err_arg(L, 2, LJ_ERR_IDXRNG);
+  lj_bufx_more(sbx, (MSize)sz);
+  if (!ctype_ctsG(G(L))) {
+    ptrdiff_t oldtop = savestack(L, L->top);
+    luaopen_ffi(L);  /* Load FFI library on-demand. */
+    L->top = restorestack(L, oldtop);
+  }
+  cts = ctype_cts(L);
+  id = lj_ctype_intern(cts, CTINFO(CT_PTR, CTALIGN_PTR|CTID_UINT8),
+		       CTSIZE_PTR);
+  cd = lj_cdata_new(cts, id, CTSIZE_PTR);
+  *(void **)cdataptr(cd) = sbufP(&sbx->sb);
+  setcdataV(L, L->top++, cd);
+  setintV(L->top++, (int32_t)sbufleft(&sbx->sb));
+  lj_gc_check(L);
+  return 2;
+}
+
+LJLIB_CF(buffer_method_commit)
+{
+  SBufExt *sbx = buffer_tobuf(L);
+  MSize len = (MSize)lj_lib_checkint(L, 2);
+  if (len > sbufleft(&sbx->sb)) lj_err_arg(L, 2, LJ_ERR_IDXRNG);
+  setsbufP(&sbx->sb, sbufP(&sbx->sb) + len);
+  return buffer_ret(L);
+}
+#endif
+
+LJLIB_CF(buffer_method_tostring)	LJLIB_REC(buffer_tostring)
+{
+  SBufExt *sbx = buffer_tobuf(L);
+  setstrV(L, L->top-1, lj_bufx_tostr(L, sbx));
+  lj_gc_check(L);
+  return 1;
+}
+LJLIB_PUSH(lastcl) LJLIB_SET(__tostring)
+
+LJLIB_CF(buffer_method___len)
+{
+  SBufExt *sbx = buffer_tobuf(L);
+  setintV(L->top-1, (int32_t)sbufxlen(sbx));
+  return 1;
+}
+
+LJLIB_PUSH(top-1) LJLIB_SET(__index)
+
+#include "lj_libdef.h"
+
+/* -- Buffer library functions -------------------------------------------- */
+
+#define LJLIB_MODULE_buffer
+
+LJLIB_PUSH(top-2) LJLIB_SET(!)  /* Set environment. */
+
+LJLIB_CF(buffer_new)
+{
+  int32_t sz = lj_lib_optint(L, 1, 0);
+  SBufExt *sbx = (SBufExt *)lua_newuserdata(L, sizeof(SBufExt));
+  GCudata *ud = udataV(L->top-1);
+  lj_bufx_init(L, sbx);
+  ud->udtype = UDTYPE_BUFFER;
+  /* NOBARRIER: The GCudata is new (marked white). */
+  setgcrefr(ud->metatable, curr_func(L)->c.env);
+  if (sz > 0) lj_buf_need(&sbx->sb, (MSize)sz);
+  return 1;
+}
+
+LJLIB_CF(buffer_encode)
+{
+  cTValue *o = lj_lib_checkany(L, 1);
+  SBuf *sb = lj_serialize_put(lj_buf_tmp_(L), o);
+  setstrV(L, L->top++, lj_buf_str(L, sb));
+  lj_gc_check(L);
+  return 1;
+}
+
+LJLIB_CF(buffer_decode)
+{
+  GCstr *str = lj_lib_checkstr(L, 1);
+  const char *e = strdata(str) + str->len;
+  setnilV(L->top++);
+  if (lj_serialize_get(L, strdata(str), e, L->top-1) != e)
+    lj_err_caller(L, LJ_ERR_BUFFER_LEFTOV);
+  lj_gc_check(L);
+  return 1;
+}
+
+#include "lj_libdef.h"
+
+/* ------------------------------------------------------------------------ */
+
+int luaopen_string_buffer(lua_State *L)
+{
+  LJ_LIB_REG(L, NULL, buffer_method);
+  LJ_LIB_REG(L, NULL, buffer);
+  return 1;
+}
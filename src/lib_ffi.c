@@ -813,6 +813,20 @@ LJLIB_CF(ffi_load)
   return 1;
 }
 
+LJLIB_CF(ffi_preload)
+{
+  TValue *o = L->base;
+  GCtab *names = NULL;
+  if (!(o < L->top && tvisudata(o) && udataV(o)->udtype == UDTYPE_FFI_CLIB))
+    lj_err_argt(L, 1, LUA_TUSERDATA);
+  if (o+1 < L->top && !tvisnil(o+1))
+    names = lj_lib_checktab(L, 2);
+  setintV(L->top++, (int32_t)lj_clib_preload(L, (CLibrary *)uddata(udataV(o)),
+					     names));
+  lj_gc_check(L);
+  return 1;
+}
+
 LJLIB_PUSH(top-4) LJLIB_SET(C)
 LJLIB_PUSH(top-3) LJLIB_SET(os)
 LJLIB_PUSH(top-2) LJLIB_SET(arch)
@@ -26,6 +26,18 @@
 #include "lj_ff.h"
 #include "lj_lib.h"
 
+#if LJ_TARGET_POSIX
+#include <sys/stat.h>
+#endif
+
+#if LJ_32 && defined(__ANDROID__) && __ANDROID_API__ < 24
+/* The Android NDK is such an unmatched marvel of engineering. */
+extern int fseeko32(FILE *, long int, int) __asm__("fseeko");
+extern long int ftello32(FILE *) __asm__("ftello");
+#define fseeko(fp, pos, whence)	(fseeko32((fp), (pos), (whence)))
+#define ftello(fp)		(ftello32((fp)))
+#endif
+
 /* Userdata payload for I/O file. */
 typedef struct IOFileUD {
   FILE *fp;		/* File handle. */
@@ -157,10 +169,38 @@ static int io_file_readline(lua_State *L, FILE *fp, MSize chop)
   return (int)ok;
 }
 
+/* Return number of bytes left in a regular file or 0 if unknown. */
+static MSize io_file_left(FILE *fp)
+{
+#if LJ_TARGET_POSIX
+  struct stat st;
+  off_t pos;
+  if (fstat(fileno(fp), &st) == 0 && S_ISREG(st.st_mode) &&
+      (pos = ftello(fp)) >= 0 && st.st_size > pos &&
+      (uint64_t)(st.st_size - pos) < LJ_MAX_STR-1)
+    return (MSize)(st.st_size - pos);
+#else
+  UNUSED(fp);
+#endif
+  return 0;
+}
+
 static void io_file_readall(lua_State *L, FILE *fp)
 {
-  MSize m, n;
-  for (m = LUAL_BUFFERSIZE, n = 0; ; m += m) {
+  MSize m, n = 0, left = io_file_left(fp);
+  if (left) {  /* Read rest of regular file directly into the string. */
+    GCstr *s = lj_str_prealloc(L, left+1);
+    n = (MSize)fread(strdatawr(s), 1, left+1, fp);
+    if (n <= left) {
+      setstrV(L, L->top++, lj_str_intern(L, s, n));
+      lj_gc_check(L);
+      return;
+    }
+    /* The file has grown in the meantime. Continue the slow way. */
+    memcpy(lj_buf_tmp(L, n), strdata(s), n);
+    lj_str_intern(L, s, 0);  /* Free the pre-allocated string. */
+  }
+  for (m = n < LUAL_BUFFERSIZE ? LUAL_BUFFERSIZE : n+n; ; m += m) {
     char *buf = lj_buf_tmp(L, m);
     n += (MSize)fread(buf+n, 1, m-n, fp);
     if (n != m) {
@@ -173,7 +213,13 @@ static void io_file_readall(lua_State *L, FILE *fp)
 
 static int io_file_readlen(lua_State *L, FILE *fp, MSize m)
 {
-  if (m) {
+  if (m >= LJ_MIN_STRINPLACE) {  /* Read large chunks into the string. */
+    GCstr *s = lj_str_prealloc(L, m);
+    MSize n = (MSize)fread(strdatawr(s), 1, m, fp);
+    setstrV(L, L->top++, lj_str_intern(L, s, n));
+    lj_gc_check(L);
+    return (n > 0);
+  } else if (m) {
     char *buf = lj_buf_tmp(L, m);
     MSize n = (MSize)fread(buf, 1, m, fp);
     setstrV(L, L->top++, lj_str_new(L, buf, (size_t)n));
@@ -224,16 +270,50 @@ static int io_file_read(lua_State *L, FILE *fp, int start)
   return n - start;
 }
 
+/* Write and reset buffered output. */
+static int io_file_flushbuf(FILE *fp, SBuf *sb, int status)
+{
+  MSize len = sbuflen(sb);
+  if (len) {
+    status = status && (fwrite(sbufB(sb), 1, len, fp) == len);
+    lj_buf_reset(sb);
+  }
+  return status;
+}
+
 static int io_file_write(lua_State *L, FILE *fp, int start)
 {
-  cTValue *tv;
+  cTValue *tv = L->base+start;
   int status = 1;
-  for (tv = L->base+start; tv < L->top; tv++) {
+  if (L->top - tv > 1) {
+    /* Coalesce multiple arguments into a single fwrite(), if possible. */
+    SBuf *sb = lj_buf_tmp_(L);
+    for (; tv < L->top; tv++) {
+      if (tvisstr(tv)) {
+	GCstr *str = strV(tv);
+	if (str->len >= LUAL_BUFFERSIZE) {  /* Don't copy long strings. */
+	  status = io_file_flushbuf(fp, sb, status);
+	  status = status &&
+		   (fwrite(strdata(str), 1, str->len, fp) == str->len);
+	} else {
+	  lj_buf_putstr(sb, str);
+	}
+      } else if (tvisint(tv)) {
+	lj_strfmt_putint(sb, intV(tv));
+      } else if (tvisnum(tv)) {
+	lj_strfmt_putfnum(sb, STRFMT_G14, numV(tv));
+      } else {
+	io_file_flushbuf(fp, sb, status);  /* Write preceding arguments. */
+	lj_err_argt(L, (int)(tv - L->base) + 1, LUA_TSTRING);
+      }
+    }
+    status = io_file_flushbuf(fp, sb, status);
+  } else if (tv < L->top) {
     MSize len;
     const char *p = lj_strfmt_wstrnum(L, tv, &len);
     if (!p)
       lj_err_argt(L, (int)(tv - L->base) + 1, LUA_TSTRING);
-    status = status && (fwrite(p, 1, len, fp) == len);
+    status = (fwrite(p, 1, len, fp) == len);
   }
   if (LJ_52 && status) {
     L->top = L->base+1;
@@ -244,7 +324,11 @@ static int io_file_write(lua_State *L, FILE *fp, int start)
   return luaL_fileresult(L, status, NULL);
 }
 
-static int io_file_iter(lua_State *L)
+/* -- I/O file methods ---------------------------------------------------- */
+
+#define LJLIB_MODULE_io_method
+
+LJLIB_NOREG LJLIB_CF(io_method_lines_iter)
 {
   GCfunc *fn = curr_func(L);
   IOFileUD *iof = uddata(udataV(&fn->c.upvalue[0]));
@@ -274,14 +358,10 @@ static int io_file_lines(lua_State *L)
   int n = (int)(L->top - L->base);
   if (n > LJ_MAX_UPVAL)
     lj_err_caller(L, LJ_ERR_UNPACK);
-  lua_pushcclosure(L, io_file_iter, n);
+  lj_lib_pushcc(L, lj_cf_io_method_lines_iter, FF_io_method_lines_iter, n);
   return 1;
 }
 
-/* -- I/O file methods ---------------------------------------------------- */
-
-#define LJLIB_MODULE_io_method
-
 LJLIB_CF(io_method_close)
 {
   IOFileUD *iof = L->base < L->top ? io_tofile(L) :
@@ -304,14 +384,6 @@ LJLIB_CF(io_method_flush)		LJLIB_REC(io_flush 0)
   return luaL_fileresult(L, fflush(io_tofile(L)->fp) == 0, NULL);
 }
 
-#if LJ_32 && defined(__ANDROID__) && __ANDROID_API__ < 24
-/* The Android NDK is such an unmatched marvel of engineering. */
-extern int fseeko32(FILE *, long int, int) __asm__("fseeko");
-extern long int ftello32(FILE *) __asm__("ftello");
-#define fseeko(fp, pos, whence)	(fseeko32((fp), (pos), (whence)))
-#define ftello(fp)		(ftello32((fp)))
-#endif
-
 LJLIB_CF(io_method_seek)
 {
   FILE *fp = io_tofile(L)->fp;
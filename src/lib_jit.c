@@ -362,7 +362,7 @@ LJLIB_CF(jit_util_tracek)
   return 0;
 }
 
-/* local snap = jit.util.tracesnap(tr, sn) */
+/* local snap, nexit = jit.util.tracesnap(tr, sn) */
 LJLIB_CF(jit_util_tracesnap)
 {
   GCtrace *T = jit_checktrace(L);
@@ -379,7 +379,8 @@ LJLIB_CF(jit_util_tracesnap)
     for (n = 0; n < nent; n++)
       setintV(lj_tab_setint(L, t, (int32_t)(n+2)), (int32_t)map[n]);
     setintV(lj_tab_setint(L, t, (int32_t)(nent+2)), (int32_t)SNAP(255, 0, 0));
-    return 1;
+    setnumV(L->top++, (lua_Number)snap->nexit);
+    return 2;
   }
   return 0;
 }
@@ -663,6 +664,14 @@ static uint32_t jit_cpudetect(void)
   if (lj_vm_cpuid(0, vendor) && lj_vm_cpuid(1, features)) {
     flags |= ((features[2] >> 0)&1) * JIT_F_SSE3;
     flags |= ((features[2] >> 19)&1) * JIT_F_SSE4_1;
+#if LJ_64
+    /* AVX needs OSXSAVE and the OS must save the XMM and YMM state. */
+    if (((features[2] >> 27)&1) && ((features[2] >> 28)&1) &&
+	(lj_vm_xgetbv() & 6) == 6) {
+      flags |= JIT_F_AVX;
+      flags |= ((features[2] >> 12)&1) * JIT_F_FMA;
+    }
+#endif
     if (vendor[0] >= 7) {
       uint32_t xfeatures[4];
       lj_vm_cpuid(7, xfeatures);
@@ -1013,6 +1013,26 @@ static void asm_snap_prep(ASMState *as)
   }
 }
 
+/* Mark snapshots that need to unsink allocations on restore. */
+static void asm_snap_flags(ASMState *as)
+{
+  GCtrace *T = as->T;
+  SnapNo snapno;
+  for (snapno = 0; snapno < T->nsnap; snapno++) {
+    SnapShot *snap = &T->snap[snapno];
+    SnapEntry *map = &T->snapmap[snap->mapofs];
+    MSize n, nent = snap->nent;
+    snap->flags = 0;
+    for (n = 0; n < nent; n++) {
+      SnapEntry sn = map[n];
+      if (!(sn & SNAP_NORESTORE) && T->ir[snap_ref(sn)].r == RID_SUNK) {
+	snap->flags |= SNAPFLAG_SUNK;
+	break;
+      }
+    }
+  }
+}
+
 /* -- Miscellaneous helpers ----------------------------------------------- */
 
 /* Calculate stack adjustment. */
@@ -2464,6 +2484,7 @@ void lj_asm_trace(jit_State *J, GCtrace *T)
   RA_DBG_FLUSH();
   if (as->freeset != RSET_ALL)
     lj_trace_err(as->J, LJ_TRERR_BADRA);  /* Ouch! Should never happen. */
+  asm_snap_flags(as);
 
   /* Set trace entry point before fixing up tail to allow link to self. */
   T->mcode = as->mcp;
@@ -3,6 +3,21 @@
 ** Copyright (C) 2005-2020 Mike Pall. See Copyright Notice in luajit.h
 */
 
+/* -- Register allocator extensions --------------------------------------- */
+
+/* Allocate a register with a hint. */
+static Reg ra_hintalloc(ASMState *as, IRRef ref, Reg hint, RegSet allow)
+{
+  Reg r = IR(ref)->r;
+  if (ra_noreg(r)) {
+    if (!ra_hashint(r) && !iscrossref(as, ref))
+      ra_sethint(IR(ref)->r, hint);  /* Propagate register hint. */
+    r = ra_allocref(as, ref, allow);
+  }
+  ra_noweak(as, r);
+  return r;
+}
+
 /* -- Guard handling ------------------------------------------------------ */
 
 /* Generate an exit stub group at the bottom of the reserved MCode memory. */
@@ -2048,10 +2063,50 @@ static void asm_fparith(ASMState *as, IRIns *ir, x86Op xo)
     }
     right = asm_fuseload(as, rref, rset_clear(allow, dest));
   }
+  if ((as->flags & JIT_F_AVX)) {  /* 3-operand AVX form: no move needed. */
+    Reg left;
+    if (lref == rref) {
+      right = left = ra_hintalloc(as, lref, dest, RSET_FPR);
+    } else {
+      left = ra_hintalloc(as, lref, dest, right == RID_MRM ? RSET_FPR :
+					  rset_exclude(RSET_FPR, right));
+    }
+    emit_mrm(as, XO_TOXV(xo) ^ ((left-RID_MIN_FPR) << 19), dest, right);
+    return;
+  }
   emit_mrm(as, xo, dest, right);
   ra_left(as, dest, lref);
 }
 
+/* Fuse FP multiply-add/sub into an FMA3 instruction. */
+static int asm_fusemadd(ASMState *as, IRIns *ir, x86Op xv, x86Op xvr)
+{
+  IRRef lref = ir->op1, rref = ir->op2;
+  IRIns *irm;
+  if ((as->flags & (JIT_F_FMA|JIT_F_OPT_FMA)) == (JIT_F_FMA|JIT_F_OPT_FMA) &&
+      lref != rref &&
+      ((mayfuse(as, lref) && (irm = IR(lref), irm->o == IR_MUL) &&
+       ra_noreg(irm->r)) ||
+       (mayfuse(as, rref) && (irm = IR(rref), irm->o == IR_MUL) &&
+       (rref = lref, xv = xvr, ra_noreg(irm->r))))) {
+    Reg dest = ra_dest(as, ir, RSET_FPR);
+    RegSet allow = rset_exclude(RSET_FPR, dest);
+    Reg left, right;
+    if (irm->op1 == irm->op2) {
+      right = left = ra_alloc1(as, irm->op1, allow);
+    } else {
+      right = asm_fuseload(as, irm->op2, allow);
+      if (right != RID_MRM) rset_clear(allow, right);
+      left = ra_alloc1(as, irm->op1, allow);
+    }
+    /* dest = left*right +- dest, with the addend moved to dest first. */
+    emit_mrm(as, (xv|VEX_64) ^ ((left-RID_MIN_FPR) << 19), dest, right);
+    ra_left(as, dest, rref);
+    return 1;
+  }
+  return 0;
+}
+
 static void asm_intarith(ASMState *as, IRIns *ir, x86Arith xa)
 {
   IRRef lref = ir->op1;
@@ -2178,17 +2233,19 @@ static int asm_lea(ASMState *as, IRIns *ir)
 
 static void asm_add(ASMState *as, IRIns *ir)
 {
-  if (irt_isnum(ir->t))
-    asm_fparith(as, ir, XO_ADDSD);
-  else if (as->flagmcp == as->mcp || irt_is64(ir->t) || !asm_lea(as, ir))
+  if (irt_isnum(ir->t)) {
+    if (!asm_fusemadd(as, ir, XV_FMADD, XV_FMADD))
+      asm_fparith(as, ir, XO_ADDSD);
+  } else if (as->flagmcp == as->mcp || irt_is64(ir->t) || !asm_lea(as, ir))
     asm_intarith(as, ir, XOg_ADD);
 }
 
 static void asm_sub(ASMState *as, IRIns *ir)
 {
-  if (irt_isnum(ir->t))
-    asm_fparith(as, ir, XO_SUBSD);
-  else  /* Note: no need for LEA trick here. i-k is encoded as i+(-k). */
+  if (irt_isnum(ir->t)) {
+    if (!asm_fusemadd(as, ir, XV_FMSUB, XV_FNMADD))
+      asm_fparith(as, ir, XO_SUBSD);
+  } else  /* Note: no need for LEA trick here. i-k is encoded as i+(-k). */
     asm_intarith(as, ir, XOg_SUB);
 }
 
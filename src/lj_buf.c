@@ -210,7 +210,14 @@ GCstr * LJ_FASTCALL lj_buf_tostr(SBuf *sb)
 GCstr *lj_buf_cat2str(lua_State *L, GCstr *s1, GCstr *s2)
 {
   MSize len1 = s1->len, len2 = s2->len;
-  char *buf = lj_buf_tmp(L, len1 + len2);
+  char *buf;
+  if ((uint64_t)len1 + len2 >= LJ_MIN_STRINPLACE) {  /* Avoid extra copy. */
+    GCstr *s = lj_str_prealloc(L, (MSize)((uint64_t)len1 + len2));
+    memcpy(strdatawr(s), strdata(s1), len1);
+    memcpy(strdatawr(s)+len1, strdata(s2), len2);
+    return lj_str_intern(L, s, s->len);
+  }
+  buf = lj_buf_tmp(L, len1 + len2);
   memcpy(buf, strdata(s1), len1);
   memcpy(buf+len1, strdata(s2), len2);
   return lj_str_new(L, buf, len1 + len2);
@@ -230,3 +237,62 @@ uint32_t LJ_FASTCALL lj_buf_ruleb128(const char **pp)
   return v;
 }
 
+
+/* -- Extended string buffers --------------------------------------------- */
+
+/* Reclaim the consumed space in front of the read position first and only
+** grow the buffer if that is not sufficient.
+*/
+LJ_NOINLINE char * LJ_FASTCALL lj_bufx_more2(SBufExt *sbx, MSize sz)
+{
+  SBuf *sb = &sbx->sb;
+  if (sbx->r) {
+    MSize len = sbufxlen(sbx);
+    char *b = sbufB(sb);
+    memmove(b, b + sbx->r, len);
+    setsbufP(sb, b + len);
+    sbx->r = 0;
+    if (sz <= sbufleft(sb))
+      return sbufP(sb);
+  }
+  return lj_buf_more2(sb, sz);
+}
+
+/* The following functions are called from JIT-compiled code, too. */
+
+SBufExt *lj_bufx_putstr(lua_State *L, SBufExt *sbx, GCstr *s)
+{
+  MSize len = s->len;
+  char *p;
+  setsbufL(&sbx->sb, L);
+  p = lj_bufx_more(sbx, len);
+  setsbufP(&sbx->sb, lj_buf_wmem(p, strdata(s), len));
+  return sbx;
+}
+
+SBufExt *lj_bufx_putint(lua_State *L, SBufExt *sbx, int32_t k)
+{
+  setsbufL(&sbx->sb, L);
+  setsbufP(&sbx->sb, lj_strfmt_wint(lj_bufx_more(sbx, STRFMT_MAXBUF_INT), k));
+  return sbx;
+}
+
+SBufExt *lj_bufx_putnum(lua_State *L, SBufExt *sbx, lua_Number n)
+{
+  setsbufL(&sbx->sb, L);
+  lj_bufx_more(sbx, STRFMT_MAXBUF_NUM);
+  lj_strfmt_putfnum(&sbx->sb, STRFMT_G14, n);
+  return sbx;
+}
+
+SBufExt * LJ_FASTCALL lj_bufx_reset(SBufExt *sbx)
+{
+  lj_buf_reset(&sbx->sb);
+  sbx->r = 0;
+  return sbx;
+}
+
+GCstr *lj_bufx_tostr(lua_State *L, SBufExt *sbx)
+{
+  return lj_str_new(L, sbufxR(sbx), sbufxlen(sbx));
+}
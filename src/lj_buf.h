@@ -100,4 +100,45 @@ static LJ_AINLINE GCstr *lj_buf_str(lua_State *L, SBuf *sb)
   return lj_str_new(L, sbufB(sb), sbuflen(sb));
 }
 
+/* -- Extended string buffers --------------------------------------------- */
+
+/* String buffer object with a read position. Payload of UDTYPE_BUFFER. */
+typedef struct SBufExt {
+  SBuf sb;		/* Underlying buffer. Must be first. */
+  MSize r;		/* Read offset relative to buffer base. */
+} SBufExt;
+
+#define sbufxR(sbx)	(sbufB(&(sbx)->sb) + (sbx)->r)
+#define sbufxlen(sbx)	(sbuflen(&(sbx)->sb) - (sbx)->r)
+
+LJ_FUNC char * LJ_FASTCALL lj_bufx_more2(SBufExt *sbx, MSize sz);
+LJ_FUNC SBufExt *lj_bufx_putstr(lua_State *L, SBufExt *sbx, GCstr *s);
+LJ_FUNC SBufExt *lj_bufx_putint(lua_State *L, SBufExt *sbx, int32_t k);
+LJ_FUNC SBufExt *lj_bufx_putnum(lua_State *L, SBufExt *sbx, lua_Number n);
+LJ_FUNC SBufExt * LJ_FASTCALL lj_bufx_reset(SBufExt *sbx);
+LJ_FUNC GCstr *lj_bufx_tostr(lua_State *L, SBufExt *sbx);
+
+static LJ_AINLINE void lj_bufx_init(lua_State *L, SBufExt *sbx)
+{
+  lj_buf_init(L, &sbx->sb);
+  sbx->r = 0;
+}
+
+/* Like lj_buf_more(), but reclaims already consumed space before growing. */
+static LJ_AINLINE char *lj_bufx_more(SBufExt *sbx, MSize sz)
+{
+  if (LJ_UNLIKELY(sz > sbufleft(&sbx->sb)))
+    return lj_bufx_more2(sbx, sz);
+  return sbufP(&sbx->sb);
+}
+
+/* Rewind a fully drained buffer, so the space can be reused for free. */
+static LJ_AINLINE void lj_bufx_rewind(SBufExt *sbx)
+{
+  if (sbx->r == sbuflen(&sbx->sb)) {
+    lj_buf_reset(&sbx->sb);
+    sbx->r = 0;
+  }
+}
+
 #endif
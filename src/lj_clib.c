@@ -338,6 +338,42 @@ static const char *clib_extsym(CTState *cts, CType *ct, GCstr *name)
   return strdata(name);
 }
 
+/* Resolve a C function or external variable. Returns NULL if not found. */
+static void *clib_resolve(lua_State *L, CLibrary *cl, CTState *cts, CType *ct,
+			  const char *sym)
+{
+  void *p = clib_getsym(cl, sym);
+  lj_assertCTS(ctype_isfunc(ct->info) || ctype_isextern(ct->info),
+	       "unexpected ctype %08x in clib", ct->info);
+#if LJ_TARGET_X86 && LJ_ABI_WIN
+  /* Retry with decorated name for fastcall/stdcall functions. */
+  if (!p && ctype_isfunc(ct->info)) {
+    CTInfo cconv = ctype_cconv(ct->info);
+    if (cconv == CTCC_FASTCALL || cconv == CTCC_STDCALL) {
+      CTSize sz = clib_func_argsize(cts, ct);
+      const char *symd = lj_strfmt_pushf(L,
+			   cconv == CTCC_FASTCALL ? "@%s@%d" : "_%s@%d",
+			   sym, sz);
+      L->top--;
+      p = clib_getsym(cl, symd);
+    }
+  }
+#else
+  UNUSED(L); UNUSED(cts);
+#endif
+  return p;
+}
+
+/* Store a resolved symbol in a cache slot. */
+static void clib_setsym(lua_State *L, CLibrary *cl, CTState *cts, TValue *tv,
+			CTypeID id, void *p)
+{
+  GCcdata *cd = lj_cdata_new(cts, id, CTSIZE_PTR);
+  *(void **)cdataptr(cd) = p;
+  setcdataV(L, tv, cd);
+  lj_gc_anybarriert(L, cl->cache);
+}
+
 /* Index a C library by name. */
 TValue *lj_clib_index(lua_State *L, CLibrary *cl, GCstr *name)
 {
@@ -361,38 +397,89 @@ TValue *lj_clib_index(lua_State *L, CLibrary *cl, GCstr *name)
 #if LJ_TARGET_WINDOWS
       DWORD oldwerr = GetLastError();
 #endif
-      void *p = clib_getsym(cl, sym);
-      GCcdata *cd;
-      lj_assertCTS(ctype_isfunc(ct->info) || ctype_isextern(ct->info),
-		   "unexpected ctype %08x in clib", ct->info);
-#if LJ_TARGET_X86 && LJ_ABI_WIN
-      /* Retry with decorated name for fastcall/stdcall functions. */
-      if (!p && ctype_isfunc(ct->info)) {
-	CTInfo cconv = ctype_cconv(ct->info);
-	if (cconv == CTCC_FASTCALL || cconv == CTCC_STDCALL) {
-	  CTSize sz = clib_func_argsize(cts, ct);
-	  const char *symd = lj_strfmt_pushf(L,
-			       cconv == CTCC_FASTCALL ? "@%s@%d" : "_%s@%d",
-			       sym, sz);
-	  L->top--;
-	  p = clib_getsym(cl, symd);
-	}
-      }
-#endif
+      void *p = clib_resolve(L, cl, cts, ct, sym);
       if (!p)
 	clib_error(L, "cannot resolve symbol " LUA_QS ": %s", sym);
 #if LJ_TARGET_WINDOWS
       SetLastError(oldwerr);
 #endif
-      cd = lj_cdata_new(cts, id, CTSIZE_PTR);
-      *(void **)cdataptr(cd) = p;
-      setcdataV(L, tv, cd);
-      lj_gc_anybarriert(L, cl->cache);
+      clib_setsym(L, cl, cts, tv, id, p);
     }
   }
   return tv;
 }
 
+/* Preload a single declared symbol. Returns 1 if it has been resolved. */
+static int clib_preload1(lua_State *L, CLibrary *cl, CTState *cts,
+			 CTypeID id, CType *ct, GCstr *name, int strict)
+{
+  cTValue *tv = lj_tab_getstr(cl->cache, name);
+  const char *sym;
+  void *p;
+  if (tv && !tvisnil(tv))
+    return 0;  /* Already resolved. */
+  sym = clib_extsym(cts, ct, name);
+  p = clib_resolve(L, cl, cts, ct, sym);
+  if (!p) {
+    if (strict)
+      clib_error(L, "cannot resolve symbol " LUA_QS ": %s", sym);
+    return 0;
+  }
+  clib_setsym(L, cl, cts, lj_tab_setstr(L, cl->cache, name), id, p);
+  return 1;
+}
+
+/* Bulk resolve declared symbols of a C library.
+**
+** With a names table, resolve each listed symbol, raising an error for
+** undeclared or unresolvable names. Otherwise resolve all declared
+** functions and external variables, silently skipping symbols which are
+** not in the library.
+** Returns the number of newly resolved symbols.
+*/
+MSize lj_clib_preload(lua_State *L, CLibrary *cl, GCtab *names)
+{
+  CTState *cts = ctype_cts(L);
+  MSize n = 0;
+#if LJ_TARGET_WINDOWS
+  DWORD oldwerr = GetLastError();
+#endif
+  if (names) {
+    int32_t i, len = (int32_t)lj_tab_len(names);
+    for (i = 1; i <= len; i++) {
+      cTValue *o = lj_tab_getint(names, i);
+      CType *ct;
+      CTypeID id;
+      GCstr *name;
+      if (!o || !tvisstr(o))
+	lj_err_caller(L, LJ_ERR_BADVAL);
+      name = strV(o);
+      id = lj_ctype_getname(cts, &ct, name, CLNS_INDEX);
+      if (!id)
+	lj_err_callerv(L, LJ_ERR_FFI_NODECL, strdata(name));
+      if (!ctype_isconstval(ct->info))
+	n += clib_preload1(L, cl, cts, id, ct, name, 1);
+    }
+  } else {
+    CTypeID id;
+    for (id = 1; id < cts->top; id++) {
+      CType *ct = ctype_get(cts, id);
+      if ((ctype_isfunc(ct->info) || ctype_isextern(ct->info)) &&
+	  gcref(ct->name)) {
+	GCstr *name = gco2str(gcref(ct->name));
+	CType *ctn;
+	/* Skip unnamed function types and shadowed declarations. */
+	if (lj_ctype_getname(cts, &ctn, name, CLNS_INDEX) == id)
+	  n += clib_preload1(L, cl, cts, id, ct, name, 0);
+      }
+    }
+  }
+#if LJ_TARGET_WINDOWS
+  SetLastError(oldwerr);
+#endif
+  return n;
+}
+
 /* -- C library management ------------------------------------------------ */
 
 /* Create a new CLibrary object and push it on the stack. */
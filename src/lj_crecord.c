@@ -12,6 +12,7 @@
 
 #include "lj_err.h"
 #include "lj_tab.h"
+#include "lj_meta.h"
 #include "lj_frame.h"
 #include "lj_ctype.h"
 #include "lj_cdata.h"
@@ -503,9 +504,25 @@ static TRef crec_ct_ct(jit_State *J, CType *d, CType *s, TRef dp, TRef sp,
   /* Destination is a vector. */
   case CCX(V, I):
   case CCX(V, F):
-  case CCX(V, C):
+  case CCX(V, C): {
+    CTState *cts = ctype_ctsG(J2G(J));
+    CType *dc = ctype_rawchild(cts, d);  /* Vector element type. */
+    CTSize ofs, esize = dc->size;
+    if (dp == 0) goto err_conv;
+    if (esize * CREC_FILL_MAXUNROLL < dsize) goto err_nyi;
+    /* Convert the scalar for each element (splat). The conversion is CSEd. */
+    for (ofs = 0; ofs < dsize; ofs += esize) {
+      TRef ptr = ofs ? emitir(IRT(IR_ADD, IRT_PTR), dp, lj_ir_kintp(J, ofs)) :
+		       dp;
+      crec_ct_ct(J, dc, s, ptr, sp, svisnz);
+    }
+    break;
+    }
   case CCX(V, V):
-    goto err_nyi;
+    /* Copy same-sized vectors, even for different lengths/element-types. */
+    if (dp == 0 || dsize != ssize) goto err_conv;
+    crec_copy(J, dp, sp, lj_ir_kint(J, dsize), d);
+    break;
 
   /* Destination is a pointer. */
   case CCX(P, P):
@@ -586,8 +603,12 @@ static TRef crec_tv_ct(jit_State *J, CType *s, CTypeID sid, TRef sp)
     ptr = emitir(IRT(IR_ADD, IRT_PTR), dp, lj_ir_kintp(J, sizeof(GCcdata)+esz));
     emitir(IRT(IR_XSTORE, t), ptr, tr2);
     return dp;
+  } else if (ctype_isvector(sinfo)) {  /* Copy vector by value. */
+    TRef dp = emitir(IRTG(IR_CNEW, IRT_CDATA), lj_ir_kint(J, sid), TREF_NIL);
+    TRef ptr = emitir(IRT(IR_ADD, IRT_PTR), dp, lj_ir_kintp(J, sizeof(GCcdata)));
+    crec_copy(J, ptr, sp, lj_ir_kint(J, s->size), s);
+    return dp;
   } else {
-    /* NYI: copyval of vectors. */
   err_nyi:
     lj_trace_err(J, LJ_TRERR_NYICONV);
   }
@@ -728,6 +749,23 @@ static void crec_tailcall(jit_State *J, RecordFFData *rd, cTValue *tv)
   rd->nres = -1;  /* Pending tailcall. */
 }
 
+/* Specialize to the key of a lookup in a ctype __index table. */
+static int crec_index_kspec(jit_State *J, TRef tr, cTValue *key)
+{
+  if (tref_isstr(tr)) {
+    emitir(IRTG(IR_EQ, IRT_STR), tr, lj_ir_kstr(J, strV(key)));
+  } else if (tref_isinteger(tr)) {
+    emitir(IRTGI(IR_EQ), tr,
+	   lj_ir_kint(J, tvisint(key) ? intV(key) : lj_num2int(numV(key))));
+  } else if (tref_isnum(tr)) {
+    if (tvisnan(key)) return 0;
+    emitir(IRTG(IR_EQ, IRT_NUM), tr, lj_ir_knum(J, numV(key)));
+  } else if (!tref_isbool(tr)) {  /* Booleans are specialized by type. */
+    return 0;  /* NYI: other key types. */
+  }
+  return 1;
+}
+
 /* Record ctype __index/__newindex metamethods. */
 static void crec_index_meta(jit_State *J, CTState *cts, CType *ct,
 			    RecordFFData *rd)
@@ -738,18 +776,39 @@ static void crec_index_meta(jit_State *J, CTState *cts, CType *ct,
     lj_trace_err(J, LJ_TRERR_BADTYPE);
   if (tvisfunc(tv)) {
     crec_tailcall(J, rd, tv);
-  } else if (rd->data == 0 && tvistab(tv) && tref_isstr(J->base[1])) {
-    /* Specialize to result of __index lookup. */
-    cTValue *o = lj_tab_get(J->L, tabV(tv), &rd->argv[1]);
+  } else if (rd->data == 0 && tvistab(tv)) {
+    /* Specialize to result of __index lookup. Follow chained tables. */
+    GCtab *t = tabV(tv);
+    cTValue *o;
+    int idxchain = LJ_MAX_IDXCHAIN;
+    if (!crec_index_kspec(J, J->base[1], &rd->argv[1]))
+      lj_trace_err(J, LJ_TRERR_BADTYPE);
+    while (tvisnil((o = lj_tab_get(J->L, t, &rd->argv[1])))) {
+      GCtab *mt = tabref(t->metatable);
+      cTValue *mo = mt ? lj_meta_fast(J->L, mt, MM_index) : NULL;
+      if (!(mo && tvistab(mo)) || --idxchain == 0)
+	break;  /* NYI: __index functions of __index tables. */
+      t = tabV(mo);
+    }
     J->base[0] = lj_record_constify(J, o);
     if (!J->base[0])
       lj_trace_err(J, LJ_TRERR_BADTYPE);
-    /* Always specialize to the key. */
-    emitir(IRTG(IR_EQ, IRT_STR), J->base[1], lj_ir_kstr(J, strV(&rd->argv[1])));
+  } else if (rd->data && tvistab(tv) && !gcref(tabV(tv)->metatable)) {
+    /* Record store to plain __newindex table. */
+    RecordIndex ix;
+    ix.tab = lj_ir_ktab(J, tabV(tv));
+    settabV(J->L, &ix.tabv, tabV(tv));
+    ix.key = J->base[1];
+    copyTV(J->L, &ix.keyv, &rd->argv[1]);
+    ix.val = J->base[2];
+    copyTV(J->L, &ix.valv, &rd->argv[2]);
+    ix.idxchain = LJ_MAX_IDXCHAIN;  /* Guards against a later metatable. */
+    lj_record_idx(J, &ix);
+    rd->nres = 0;
+    J->needsnap = 1;
   } else {
     /* NYI: resolving of non-function metamethods. */
-    /* NYI: non-string keys for __index table. */
-    /* NYI: stores to __newindex table. */
+    /* NYI: stores to __newindex table with a metatable. */
     lj_trace_err(J, LJ_TRERR_BADTYPE);
   }
 }
@@ -1362,10 +1421,36 @@ static TRef crec_arith_ptr(jit_State *J, TRef *sp, CType **s, MMS mm)
       if (mm == MM_sub) {  /* Pointer difference. */
 	TRef tr;
 	CTSize sz = lj_ctype_size(cts, ctype_cid(ctp->info));
-	if (sz == 0 || (sz & (sz-1)) != 0)
-	  return 0;  /* NYI: integer division. */
+	uint32_t sh;
+	if (sz == 0 || sz == CTSIZE_INVALID)
+	  return 0;
+	sh = lj_ffs(sz);
 	tr = emitir(IRT(IR_SUB, IRT_INTP), sp[0], sp[1]);
-	tr = emitir(IRT(IR_BSAR, IRT_INTP), tr, lj_ir_kint(J, lj_fls(sz)));
+	if ((sz >> sh) != 1) {
+	  /* Divide by the odd part k via multiplication with its inverse.
+	  ** This is only exact for multiples of the element size. Otherwise
+	  ** exit, since the interpreter uses a truncating division.
+	  ** The low sh bits must be zero. A multiple of k times the inverse
+	  ** gives a result in [-c, c], anything else is outside of it.
+	  */
+	  uintptr_t k = (uintptr_t)(sz >> sh), inv = k;
+	  uintptr_t c = (~(uintptr_t)0 >> 1) / k;
+	  int i;
+	  for (i = 0; i < 5; i++) inv *= 2 - k*inv;  /* Newton iteration. */
+	  if (sh) {
+	    emitir(IRTG(IR_EQ, IRT_INTP),
+		   emitir(IRT(IR_BAND, IRT_INTP), tr,
+			  lj_ir_kintp(J, ((uintptr_t)1 << sh) - 1)),
+		   lj_ir_kintp(J, 0));
+	    tr = emitir(IRT(IR_BSAR, IRT_INTP), tr, lj_ir_kint(J, (int32_t)sh));
+	  }
+	  tr = emitir(IRT(IR_MUL, IRT_INTP), tr, lj_ir_kintp(J, inv));
+	  emitir(IRTG(IR_ULE, IRT_INTP),
+		 emitir(IRT(IR_ADD, IRT_INTP), tr, lj_ir_kintp(J, c)),
+		 lj_ir_kintp(J, 2*c));
+	} else if (sh) {
+	  tr = emitir(IRT(IR_BSAR, IRT_INTP), tr, lj_ir_kint(J, (int32_t)sh));
+	}
 #if LJ_64
 	tr = emitconv(tr, IRT_NUM, IRT_INTP, 0);
 #endif
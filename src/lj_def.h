@@ -69,6 +69,8 @@ typedef unsigned int uintptr_t;
 #define LJ_MAX_UPVAL	60		/* Max. # of upvalues. */
 
 #define LJ_MAX_IDXCHAIN	100		/* __index/__newindex chain limit. */
+#define LJ_MAX_SERDEPTH	100		/* Max. nesting of serialized objects. */
+#define LJ_MAX_SERDICT	(1<<16)		/* Max. # of serializer dict. strings. */
 #define LJ_STACK_EXTRA	(5+2*LJ_FR2)	/* Extra stack space (metamethods). */
 
 #define LJ_NUM_CBPAGE	1		/* Number of FFI callback pages. */
@@ -78,6 +80,7 @@ typedef unsigned int uintptr_t;
 #define LJ_MIN_REGISTRY	2		/* Min. registry size (hbits). */
 #define LJ_MIN_STRTAB	256		/* Min. string table size (pow2). */
 #define LJ_MIN_SBUF	32		/* Min. string buffer length. */
+#define LJ_MIN_STRINPLACE 128		/* Min. length to concat in place. */
 #define LJ_MIN_VECSZ	8		/* Min. size for growable vectors. */
 #define LJ_MIN_IRSZ	32		/* Min. size for growable IR. */
 
@@ -1136,6 +1136,51 @@ static void LJ_FASTCALL recff_io_flush(jit_State *J, RecordFFData *rd)
   J->base[0] = TREF_TRUE;
 }
 
+/* -- Buffer library fast functions --------------------------------------- */
+
+/* Get pointer to SBufExt of a buffer object passed as the first argument. */
+static TRef recff_sbufx(jit_State *J, RecordFFData *rd)
+{
+  TRef tr, ud = J->base[0];
+  if (!(tref_isudata(ud) && udataV(&rd->argv[0])->udtype == UDTYPE_BUFFER))
+    lj_trace_err(J, LJ_TRERR_BADTYPE);
+  tr = emitir(IRT(IR_FLOAD, IRT_U8), ud, IRFL_UDATA_UDTYPE);
+  emitir(IRTGI(IR_EQ), tr, lj_ir_kint(J, UDTYPE_BUFFER));
+  return emitir(IRT(IR_ADD, IRT_PTR), ud, lj_ir_kintp(J, sizeof(GCudata)));
+}
+
+static void LJ_FASTCALL recff_buffer_put(jit_State *J, RecordFFData *rd)
+{
+  TRef sbx;
+  ptrdiff_t i;
+  for (i = 1; J->base[i]; i++)  /* Check all args before emitting any call. */
+    if (!(tref_isstr(J->base[i]) || tref_isnumber(J->base[i]))) {
+      recff_nyiu(J, rd);
+      return;
+    }
+  sbx = recff_sbufx(J, rd);
+  for (i = 1; J->base[i]; i++) {
+    TRef tr = J->base[i];
+    if (tref_isstr(tr))
+      lj_ir_call(J, IRCALL_lj_bufx_putstr, sbx, tr);
+    else if (tref_isinteger(tr))
+      lj_ir_call(J, IRCALL_lj_bufx_putint, sbx, tr);
+    else
+      lj_ir_call(J, IRCALL_lj_bufx_putnum, sbx, tr);
+  }
+  /* Returns the buffer object itself in J->base[0]. */
+}
+
+static void LJ_FASTCALL recff_buffer_reset(jit_State *J, RecordFFData *rd)
+{
+  lj_ir_call(J, IRCALL_lj_bufx_reset, recff_sbufx(J, rd));
+}
+
+static void LJ_FASTCALL recff_buffer_tostring(jit_State *J, RecordFFData *rd)
+{
+  J->base[0] = lj_ir_call(J, IRCALL_lj_bufx_tostr, recff_sbufx(J, rd));
+}
+
 /* -- Debug library fast functions ---------------------------------------- */
 
 static void LJ_FASTCALL recff_debug_getmetatable(jit_State *J, RecordFFData *rd)
@@ -162,6 +162,11 @@ typedef struct CCallInfo {
   _(ANY,	lj_buf_putstr_rep,	3,   L, PGC, 0) \
   _(ANY,	lj_buf_puttab,		5,   L, PGC, 0) \
   _(ANY,	lj_buf_tostr,		1,  FL, STR, 0) \
+  _(ANY,	lj_bufx_putstr,		3,   S, PTR, CCI_L) \
+  _(ANY,	lj_bufx_putint,		3,   S, PTR, CCI_L) \
+  _(ANY,	lj_bufx_putnum,		3,   S, PTR, CCI_L|XA_FP) \
+  _(ANY,	lj_bufx_reset,		1,  FS, PTR, 0) \
+  _(ANY,	lj_bufx_tostr,		2,   A, STR, CCI_L) \
   _(ANY,	lj_tab_new_ah,		3,   A, TAB, CCI_L) \
   _(ANY,	lj_tab_new1,		2,  FS, TAB, CCI_L) \
   _(ANY,	lj_tab_dup,		2,  FS, TAB, CCI_L) \
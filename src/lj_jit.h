@@ -22,9 +22,11 @@
 #define JIT_F_SSE3		(JIT_F_CPU << 0)
 #define JIT_F_SSE4_1		(JIT_F_CPU << 1)
 #define JIT_F_BMI2		(JIT_F_CPU << 2)
+#define JIT_F_AVX		(JIT_F_CPU << 3)
+#define JIT_F_FMA		(JIT_F_CPU << 4)
 
 
-#define JIT_F_CPUSTRING		"\4SSE3\6SSE4.1\4BMI2"
+#define JIT_F_CPUSTRING		"\4SSE3\6SSE4.1\4BMI2\3AVX\3FMA"
 
 #elif LJ_TARGET_ARM
 
@@ -86,10 +88,11 @@
 #define JIT_F_OPT_ABC		(JIT_F_OPT << 7)
 #define JIT_F_OPT_SINK		(JIT_F_OPT << 8)
 #define JIT_F_OPT_FUSE		(JIT_F_OPT << 9)
+#define JIT_F_OPT_FMA		(JIT_F_OPT << 10)
 
 /* Optimizations names for -O. Must match the order above. */
 #define JIT_F_OPTSTRING	\
-  "\4fold\3cse\3dce\3fwd\3dse\6narrow\4loop\3abc\4sink\4fuse"
+  "\4fold\3cse\3dce\3fwd\3dse\6narrow\4loop\3abc\4sink\4fuse\3fma"
 
 /* Optimization levels set a fixed combination of flags. */
 #define JIT_F_OPT_0	0
@@ -98,6 +101,7 @@
 #define JIT_F_OPT_3	(JIT_F_OPT_2|\
   JIT_F_OPT_FWD|JIT_F_OPT_DSE|JIT_F_OPT_ABC|JIT_F_OPT_SINK|JIT_F_OPT_FUSE)
 #define JIT_F_OPT_DEFAULT	JIT_F_OPT_3
+/* Note: FMA is not set by default, since fused results are rounded once. */
 
 /* -- JIT engine parameters ----------------------------------------------- */
 
@@ -188,10 +192,14 @@ typedef struct SnapShot {
   uint8_t topslot;	/* Maximum frame extent. */
   uint8_t nent;		/* Number of compressed entries. */
   uint8_t count;	/* Count of taken exits for this snapshot. */
+  uint8_t flags;	/* Snapshot flags. */
+  uint32_t nexit;	/* Total number of taken exits (saturated). */
 } SnapShot;
 
 #define SNAPCOUNT_DONE	255	/* Already compiled and linked a side trace. */
 
+#define SNAPFLAG_SUNK	0x01	/* Restore may need to unsink allocations. */
+
 /* Compressed snapshot entry. */
 typedef uint32_t SnapEntry;
 
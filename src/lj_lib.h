@@ -91,6 +91,9 @@ LJ_FUNC void lj_lib_prereg(lua_State *L, const char *name, lua_CFunction f,
 LJ_FUNC int lj_lib_postreg(lua_State *L, lua_CFunction cf, int id,
 			   const char *name);
 
+/* Library loaders which are not exported by lualib.h. */
+LJ_FUNC int luaopen_string_buffer(lua_State *L);
+
 /* Library init data tags. */
 #define LIBINIT_LENMASK	0x3f
 #define LIBINIT_TAGMASK	0xc0
@@ -278,11 +278,25 @@ TValue *lj_meta_cat(lua_State *L, TValue *top, int left)
       */
       TValue *e, *o = top;
       uint64_t tlen = tvisstr(o) ? strV(o)->len : STRFMT_MAXBUF_NUM;
+      int isstr = tvisstr(o);
       SBuf *sb;
       do {
 	o--; tlen += tvisstr(o) ? strV(o)->len : STRFMT_MAXBUF_NUM;
+	isstr &= tvisstr(o);
       } while (--left > 0 && (tvisstr(o-1) || tvisnumber(o-1)));
       if (tlen >= LJ_MAX_STR) lj_err_msg(L, LJ_ERR_STROV);
+      if (isstr && tlen >= LJ_MIN_STRINPLACE) {
+	/* Concatenate long strings in place, without a temporary buffer. */
+	GCstr *s = lj_str_prealloc(L, (MSize)tlen);
+	char *p = strdatawr(s);
+	for (e = top, top = o; o <= e; o++) {
+	  MSize len = strV(o)->len;
+	  memcpy(p, strdata(strV(o)), len);
+	  p += len;
+	}
+	setstrV(L, top, lj_str_intern(L, s, s->len));
+	continue;
+      }
       sb = lj_buf_tmp_(L);
       lj_buf_more(sb, (MSize)tlen);
       for (e = top, top = o; o <= e; o++) {
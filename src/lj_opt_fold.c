@@ -1466,6 +1466,74 @@ LJFOLDF(simplify_intmod_k)
   return NEXTFOLD;
 }
 
+#if LJ_HASFFI
+/* Get log2 of a 64 bit power of two. */
+static int32_t fold_log2_64(uint64_t k)
+{
+  return (k >> 32) ? 32 + (int32_t)lj_ffs((uint32_t)(k >> 32)) :
+		     (int32_t)lj_ffs((uint32_t)k);
+}
+
+/* Rounding bias for signed division by 2^k: (i < 0) ? 2^k-1 : 0 */
+static TRef fold_sdivbias64(jit_State *J, IRRef ref, int32_t sh)
+{
+  TRef tr = emitir(IRT(IR_BSAR, IRT_I64), ref, lj_ir_kint(J, 63));
+  tr = emitir(IRT(IR_BSHR, IRT_I64), tr, lj_ir_kint(J, 64-sh));
+  return emitir(IRT(IR_ADD, IRT_I64), ref, tr);
+}
+#endif
+
+LJFOLD(DIV any KINT64)
+LJFOLDF(simplify_intdiv_k64)
+{
+#if LJ_HASFFI
+  uint64_t k = ir_kint64(fright)->u64;
+  if (k == 1)  /* i / 1 ==> i */
+    return LEFTFOLD;
+  if (k && (k & (k-1)) == 0 && (irt_isu64(fins->t) || (int64_t)k > 0)) {
+    int32_t sh = fold_log2_64(k);
+    if (irt_isu64(fins->t)) {  /* u / 2^k ==> u >> k */
+      fins->o = IR_BSHR;
+      fins->op2 = lj_ir_kint(J, sh);
+      return RETRYFOLD;
+    } else {  /* i / 2^k ==> (i + bias) >> k (arithmetic) */
+      IRRef ref = fins->op1;
+      TRef tr = fold_sdivbias64(J, ref, sh);
+      return emitir(IRT(IR_BSAR, IRT_I64), tr, lj_ir_kint(J, sh));
+    }
+  }
+  return NEXTFOLD;
+#else
+  UNUSED(J); lj_assertJ(0, "FFI IR op without FFI"); return FAILFOLD;
+#endif
+}
+
+LJFOLD(MOD any KINT64)
+LJFOLDF(simplify_intmod_k64)
+{
+#if LJ_HASFFI
+  uint64_t k = ir_kint64(fright)->u64;
+  if (k == 1)  /* i % 1 ==> 0 */
+    return INT64FOLD(0);
+  if (k && (k & (k-1)) == 0 && (irt_isu64(fins->t) || (int64_t)k > 0)) {
+    if (irt_isu64(fins->t)) {  /* u % 2^k ==> u & (2^k-1) */
+      fins->o = IR_BAND;
+      fins->op2 = (IRRef1)lj_ir_kint64(J, k-1);
+      return RETRYFOLD;
+    } else {  /* i % 2^k ==> i - ((i + bias) & -2^k) */
+      IRRef ref = fins->op1;
+      TRef tr = fold_sdivbias64(J, ref, fold_log2_64(k));
+      tr = emitir(IRT(IR_BAND, IRT_I64), tr,
+		  lj_ir_kint64(J, (uint64_t)-(int64_t)k));
+      return emitir(IRT(IR_SUB, IRT_I64), ref, tr);
+    }
+  }
+  return NEXTFOLD;
+#else
+  UNUSED(J); lj_assertJ(0, "FFI IR op without FFI"); return FAILFOLD;
+#endif
+}
+
 LJFOLD(MOD KINT any)
 LJFOLDF(simplify_intmod_kleft)
 {
@@ -1475,7 +1543,6 @@ LJFOLDF(simplify_intmod_kleft)
 }
 
 LJFOLD(SUB any any)
-LJFOLD(SUBOV any any)
 LJFOLDF(simplify_intsub)
 {
   if (fins->op1 == fins->op2 && !irt_isnum(fins->t))  /* i - i ==> 0 */
@@ -1944,13 +2011,71 @@ LJFOLDF(abc_k)
   return NEXTFOLD;
 }
 
+/* Check for loop-invariant ref. Only valid during loop unrolling. */
+#define abc_isinvar(J, ref) \
+  ((ref) < J->chain[IR_LOOP] && !irt_isphi(IR((ref))->t))
+
+/* Check for next FORL index i' in i'+x, x+i', i'-x or x-i' (plus const). */
+static int abc_isnextidx(jit_State *J, IRRef ref)
+{
+  IRIns *ir = IR(ref);
+  return ir->o == IR_ADD && ir->op1 == J->scev.idx && ir->op2 == J->scev.step;
+}
+
+/* Check for an overflow check of x+stop, stop+x, stop-x or x-stop before
+** the loop, given i'+x, x+i', i'-x or x-i' with an invariant x.
+*/
+static int abc_stopov(jit_State *J, IROp op, IRRef op1, IRRef op2)
+{
+  IRRef ref, lim;
+  if (abc_isnextidx(J, op1) && abc_isinvar(J, op2))
+    op1 = J->scev.stop;
+  else if (abc_isnextidx(J, op2) && abc_isinvar(J, op1))
+    op2 = J->scev.stop;
+  else
+    return 0;
+  lim = op1 > op2 ? op1 : op2;
+  for (ref = J->chain[op]; ref > lim; ref = IR(ref)->prev) {
+    IRIns *ir = IR(ref);
+    if ((ir->op1 == op1 && ir->op2 == op2) ||
+	(op == IR_ADDOV && ir->op1 == op2 && ir->op2 == op1))
+      return 1;
+  }
+  return 0;
+}
+
+/* Check that the only variant part of the key is the next FORL index.
+** The key must not wrap around. A plain ADD or SUB is only ok, if the
+** overflow check has been eliminated by simplify_ovloop below.
+*/
+static int abc_affine(jit_State *J, IRRef ref)
+{
+  IRIns *ir = IR(ref);
+  if (ir->o == IR_ADD && irref_isk(ir->op2))
+    ir = IR(ir->op1);
+  if (ir->o == IR_ADDOV || ir->o == IR_SUBOV) {
+    if (abc_isnextidx(J, ir->op1))
+      return abc_isinvar(J, ir->op2);
+    if (abc_isnextidx(J, ir->op2))
+      return abc_isinvar(J, ir->op1);
+  } else if (ir->o == IR_ADD || ir->o == IR_SUB) {
+    return abc_stopov(J, ir->o == IR_ADD ? IR_ADDOV : IR_SUBOV,
+		      ir->op1, ir->op2);
+  }
+  return 0;
+}
+
 /* Eliminate invariant ABC inside loop. */
 LJFOLD(ABC any any)
 LJFOLDF(abc_invar)
 {
-  /* Invariant ABC marked as PTR. Drop if op1 is invariant, too. */
-  if (!irt_isint(fins->t) && fins->op1 < J->chain[IR_LOOP] &&
-      !irt_isphi(IR(fins->op1)->t))
+  /* Invariant ABC marked as P32 or U32. Drop if op1 is invariant, too.
+  ** U32 is used for affine keys of the FORL index. The bounds check for
+  ** stop has already been emitted. But it's only valid if the key has no
+  ** other variant parts.
+  */
+  if (!irt_isint(fins->t) && abc_isinvar(J, fins->op1) &&
+      (!irt_isu32(fins->t) || abc_affine(J, fins->op2)))
     return DROPFOLD;
   return NEXTFOLD;
 }
@@ -1967,7 +2092,6 @@ LJFOLDF(abc_invar)
 
 LJFOLD(ADD any any)
 LJFOLD(MUL any any)
-LJFOLD(ADDOV any any)
 LJFOLD(MULOV any any)
 LJFOLDF(comm_swap)
 {
@@ -1980,6 +2104,23 @@ LJFOLDF(comm_swap)
   return NEXTFOLD;
 }
 
+/* Eliminate overflow check for i'+x, x+i', i'-x or x-i' inside loop.
+** Needs an invariant x and the same check for stop of the FORL index i
+** before the loop. The check for start is the original instruction.
+** All values of i' inside the loop are between these two.
+*/
+LJFOLD(ADDOV any any)
+LJFOLD(SUBOV any any)
+LJFOLDF(simplify_ovloop)
+{
+  if (J->chain[IR_LOOP] &&
+      abc_stopov(J, (IROp)fins->o, fins->op1, fins->op2)) {
+    fins->ot = IRTI(fins->o == IR_ADDOV ? IR_ADD : IR_SUB);
+    return RETRYFOLD;
+  }
+  return fins->o == IR_ADDOV ? fold_comm_swap(J) : fold_simplify_intsub(J);
+}
+
 LJFOLD(EQ any any)
 LJFOLD(NE any any)
 LJFOLDF(comm_equal)
@@ -2059,14 +2200,18 @@ static TRef kfold_xload(jit_State *J, IRIns *ir, const void *p)
 
 /* Turn: string.sub(str, a, b) == kstr
 ** into: string.byte(str, a) == string.byte(kstr, 1) etc.
+** Same for ffi.string(ptr, len) == kstr, which avoids creating the string.
 ** Note: this creates unaligned XLOADs on x86/x64.
 */
 LJFOLD(EQ SNEW KGC)
 LJFOLD(NE SNEW KGC)
+LJFOLD(EQ XSNEW KGC)
+LJFOLD(NE XSNEW KGC)
 LJFOLDF(merge_eqne_snew_kgc)
 {
   GCstr *kstr = ir_kstr(fright);
   int32_t len = (int32_t)kstr->len;
+  IRRef xmode = IRXLOAD_READONLY;
   lj_assertJ(irt_isstr(fins->t), "bad equality IR type");
 
 #if LJ_TARGET_UNALIGNED
@@ -2081,8 +2226,18 @@ LJFOLDF(merge_eqne_snew_kgc)
   if (len <= FOLD_SNEW_MAX_LEN) {
     IROp op = (IROp)fins->o;
     IRRef strref = fleft->op1;
-    if (IR(strref)->o != IR_STRREF)
+    if (fleft->o == IR_XSNEW) {
+      /* The C memory must not have been modified since the XSNEW. */
+      IRRef ref = fins->op1;
+      if (!irt_isint(IR(fleft->op2)->t))  /* Length from strlen() is INTP. */
+	return NEXTFOLD;
+      if (J->chain[IR_XSTORE] > ref || J->chain[IR_CALLS] > ref ||
+	  J->chain[IR_CALLXS] > ref || (len == 3 && op != IR_EQ))
+	return NEXTFOLD;
+      xmode = 0;  /* Not a read-only load. */
+    } else if (IR(strref)->o != IR_STRREF) {
       return NEXTFOLD;
+    }
     if (op == IR_EQ) {
       emitir(IRTGI(IR_EQ), fleft->op2, lj_ir_kint(J, len));
       /* Caveat: fins/fleft/fright is no longer valid after emitir. */
@@ -2094,13 +2249,24 @@ LJFOLDF(merge_eqne_snew_kgc)
 	return DROPFOLD;
     }
     if (len > 0) {
+      const char *kp = strdata(kstr);
+      uint16_t ot;
+      TRef tmp, val;
+      if (len == 3 && xmode == 0) {
+	/* No extra NUL for C memory. Split into a 2 and a 1 byte compare. */
+	tmp = emitir(IRT(IR_XLOAD, IRT_U16), strref, IRXLOAD_UNALIGNED);
+	emitir(IRTGI(IR_EQ), tmp, kfold_xload(J, IR(tref_ref(tmp)), kp));
+	strref = tref_ref(emitir(IRT(IR_ADD, IRT_PTR), strref,
+				 lj_ir_kintp(J, 2)));
+	kp += 2;
+	len = 1;
+      }
       /* A 4 byte load for length 3 is ok -- all strings have an extra NUL. */
-      uint16_t ot = (uint16_t)(len == 1 ? IRT(IR_XLOAD, FOLD_SNEW_TYPE8) :
-			       len == 2 ? IRT(IR_XLOAD, IRT_U16) :
-			       IRTI(IR_XLOAD));
-      TRef tmp = emitir(ot, strref,
-			IRXLOAD_READONLY | (len > 1 ? IRXLOAD_UNALIGNED : 0));
-      TRef val = kfold_xload(J, IR(tref_ref(tmp)), strdata(kstr));
+      ot = (uint16_t)(len == 1 ? IRT(IR_XLOAD, FOLD_SNEW_TYPE8) :
+		      len == 2 ? IRT(IR_XLOAD, IRT_U16) :
+		      IRTI(IR_XLOAD));
+      tmp = emitir(ot, strref, xmode | (len > 1 ? IRXLOAD_UNALIGNED : 0));
+      val = kfold_xload(J, IR(tref_ref(tmp)), kp);
       if (len == 3)
 	tmp = emitir(IRTI(IR_BAND), tmp,
 		     lj_ir_kint(J, LJ_ENDIAN_SELECT(0x00ffffff, 0xffffff00)));
@@ -2258,9 +2424,11 @@ LJFOLDF(fload_str_len_kgc)
 }
 
 LJFOLD(FLOAD SNEW IRFL_STR_LEN)
+LJFOLD(FLOAD XSNEW IRFL_STR_LEN)
 LJFOLDF(fload_str_len_snew)
 {
-  if (LJ_LIKELY(J->flags & JIT_F_OPT_FOLD)) {
+  if (LJ_LIKELY(J->flags & JIT_F_OPT_FOLD) &&
+      irt_isint(IR(fleft->op2)->t)) {  /* Length from strlen() is INTP. */
     PHIBARRIER(fleft);
     return fleft->op2;
   }
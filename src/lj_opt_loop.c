@@ -228,6 +228,8 @@ static void loop_subst_snap(jit_State *J, SnapShot *osnap,
   snap->nslots = nslots;
   snap->topslot = osnap->topslot;
   snap->count = 0;
+  snap->flags = 0;
+  snap->nexit = 0;
   nmap = &J->cur.snapmap[nmapofs];
   /* Substitute snapshot slots. */
   on = ln = nn = 0;
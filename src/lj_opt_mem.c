@@ -888,9 +888,14 @@ TRef LJ_FASTCALL lj_opt_dse_xstore(jit_State *J)
       /* Different value: try to eliminate the redundant store. */
       if (ref > J->chain[IR_LOOP]) {  /* Quick check to avoid crossing LOOP. */
 	IRIns *ir;
-	/* Check for any intervening guards or any XLOADs (no AA performed). */
+	/* Check for any intervening guards or any aliasing XLOADs.
+	** The types may differ, so check against both stores.
+	*/
 	for (ir = IR(J->cur.nins-1); ir > store; ir--)
-	  if (irt_isguard(ir->t) || ir->o == IR_XLOAD)
+	  if (irt_isguard(ir->t) ||
+	      (ir->o == IR_XLOAD &&
+	       (aa_xref(J, IR(store->op1), store, ir) != ALIAS_NO ||
+		aa_xref(J, xr, fins, ir) != ALIAS_NO)))
 	    goto doemit;  /* No elimination possible. */
 	/* Remove redundant store from chain and replace with NOP. */
 	*refp = store->prev;
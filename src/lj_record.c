@@ -705,7 +705,7 @@ static TRef rec_call_specialize(jit_State *J, GCfunc *fn, TRef tr)
     switch (fn->c.ffid) {
     case FF_coroutine_wrap_aux:
     case FF_string_gmatch_aux:
-      /* NYI: io_file_iter doesn't have an ffid, yet. */
+    case FF_io_method_lines_iter:
       {  /* Specialize to the ffid. */
 	TRef trid = emitir(IRT(IR_FLOAD, IRT_U8), tr, IRFL_FUNC_FFID);
 	emitir(IRTG(IR_EQ, IRT_INT), trid, lj_ir_kint(J, fn->c.ffid));
@@ -823,6 +823,8 @@ void lj_record_ret(jit_State *J, BCReg rbase, ptrdiff_t gotresults)
     (void)getslot(J, rbase+i);  /* Ensure all results have a reference. */
   while (frame_ispcall(frame)) {  /* Immediately resolve pcall() returns. */
     BCReg cbase = (BCReg)frame_delta(frame);
+    if (J->framedepth == 0 && J->pt && bc_isret(bc_op(*J->pc)))
+      break;  /* Let the interpreter return to the pcall() frame below. */
     if (--J->framedepth <= 0)
       lj_trace_err(J, LJ_TRERR_NYIRETL);
     lj_assertJ(J->baseslot > 1+LJ_FR2, "bad baseslot for return");
@@ -1273,7 +1275,8 @@ static void rec_idx_bump(jit_State *J, RecordIndex *ix)
 #endif
 
 /* Record bounds-check. */
-static void rec_idx_abc(jit_State *J, TRef asizeref, TRef ikey, uint32_t asize)
+static void rec_idx_abc(jit_State *J, TRef asizeref, TRef ikey, uint32_t asize,
+			int32_t k)
 {
   /* Try to emit invariant bounds checks. */
   if ((J->flags & (JIT_F_OPT_LOOP|JIT_F_OPT_ABC)) ==
@@ -1306,6 +1309,32 @@ static void rec_idx_abc(jit_State *J, TRef asizeref, TRef ikey, uint32_t asize)
 	  emitir(IRTG(IR_ABC, IRT_P32), asizeref, ikey);
 	return;
       }
+    } else if ((ir->o == IR_ADDOV || ir->o == IR_SUBOV) &&
+	       (ir->op1 == J->scev.idx || ir->op2 == J->scev.idx) &&
+	       ir->op1 != ir->op2 && ofs > -0x40000000) {
+      /* Handle i+x, x+i, i-x and x-i. x must be loop-invariant, too.
+      ** Only with overflow checks, so the key can't wrap around between
+      ** start and stop. A wrapped constant offset fails the check.
+      */
+      IRIns *irs = IR(J->scev.idx);
+      cTValue *base = J->L->base - J->baseslot;
+      int64_t i = numberVint(&base[irs->op1 + FORL_IDX]);
+      int64_t stop = numberVint(&base[irs->op1 + FORL_STOP]);
+      int neg = ir->op2 == J->scev.idx &&
+		(ir->o == IR_SUB || ir->o == IR_SUBOV);
+      /* Runtime value of the key for stop of loop is within bounds? */
+      if ((uint64_t)(k + (neg ? i - stop : stop - i)) < (uint64_t)asize) {
+	uint16_t ot = ir->ot;
+	IRRef op1 = ir->op1 == J->scev.idx ? J->scev.stop : ir->op1;
+	IRRef op2 = ir->op2 == J->scev.idx ? J->scev.stop : ir->op2;
+	TRef tr = emitir(ot, op1, op2);
+	if (ofsref) tr = emitir(IRTI(IR_ADD), tr, ofsref);
+	/* Emit invariant bounds check for stop. */
+	emitir(IRTG(IR_ABC, IRT_P32), asizeref, tr);
+	/* Emit bounds check for start. Dropped in loop, if x is invariant. */
+	emitir(IRTG(IR_ABC, IRT_U32), asizeref, ikey);
+	return;
+      }
     }
   }
   emitir(IRTGI(IR_ABC), asizeref, ikey);  /* Emit regular bounds check. */
@@ -1332,7 +1361,7 @@ static TRef rec_idx_key(jit_State *J, RecordIndex *ix, IRRef *rbref,
       TRef asizeref = emitir(IRTI(IR_FLOAD), ix->tab, IRFL_TAB_ASIZE);
       if ((MSize)k < t->asize) {  /* Currently an array key? */
 	TRef arrayref;
-	rec_idx_abc(J, asizeref, ikey, t->asize);
+	rec_idx_abc(J, asizeref, ikey, t->asize, k);
 	arrayref = emitir(IRT(IR_FLOAD, IRT_PGC), ix->tab, IRFL_TAB_ARRAY);
 	return emitir(IRT(IR_AREF, IRT_PGC), arrayref, ikey);
       } else {  /* Currently not in array (may be an array extension)? */
@@ -1858,7 +1887,7 @@ static void rec_varg(jit_State *J, BCReg dst, ptrdiff_t nresults)
 	tr = emitir(IRTI(IR_BSHR), tmp, lj_ir_kint(J, 3));
 	if (idx != 0) {
 	  tridx = emitir(IRTI(IR_ADD), tridx, lj_ir_kint(J, -1));
-	  rec_idx_abc(J, tr, tridx, (uint32_t)nvararg);
+	  rec_idx_abc(J, tr, tridx, (uint32_t)nvararg, (int32_t)idx-1);
 	}
       } else {
 	TRef tmp = lj_ir_kint(J, frofs);
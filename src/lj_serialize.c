@@ -0,0 +1,386 @@
+/*
+** Object de/serialization.
+** Copyright (C) 2005-2020 Mike Pall. See Copyright Notice in luajit.h
+*/
+
+#define lj_serialize_c
+#define LUA_CORE
+
+#include "lj_obj.h"
+#include "lj_err.h"
+#include "lj_buf.h"
+#include "lj_str.h"
+#include "lj_tab.h"
+#include "lj_state.h"
+#if LJ_HASFFI
+#include "lualib.h"
+#include "lj_ctype.h"
+#include "lj_cdata.h"
+#endif
+#include "lj_strfmt.h"
+#include "lj_serialize.h"
+
+/* Tags for the serialization format. All multi-byte values are stored in
+** little-endian byte order. Counts and lengths are ULEB128-encoded.
+**
+**   nil, false, true        tag
+**   integer                 tag + int32_t
+**   number                  tag + double
+**   table                   tag + narray + nhash + narray values [1..narray]
+**                                                 + nhash key/value pairs
+**   string dictionary ref   tag + index of an earlier hash key string
+**   int64_t, uint64_t cdata tag + 8 bytes
+**   complex cdata           tag + 2*8 bytes
+**   string                  (tag + length) + string data
+**
+** The first occurrence of a string used as a table key is added to the
+** string dictionary by both the encoder and the decoder. Later occurrences
+** of the same string are encoded as a reference to the dictionary entry.
+*/
+enum {
+  SER_TAG_NIL,
+  SER_TAG_FALSE,
+  SER_TAG_TRUE,
+  SER_TAG_INT,
+  SER_TAG_NUM,
+  SER_TAG_TAB,
+  SER_TAG_DICT,
+  SER_TAG_INT64,
+  SER_TAG_UINT64,
+  SER_TAG_COMPLEX,
+  SER_TAG_STR = 0x20
+};
+
+/* -- Helper functions ---------------------------------------------------- */
+
+static LJ_AINLINE char *serialize_wu32(char *w, uint32_t v)
+{
+#if LJ_BE
+  v = lj_bswap(v);
+#endif
+  memcpy(w, &v, 4);
+  return w+4;
+}
+
+static LJ_AINLINE char *serialize_wu64(char *w, uint64_t v)
+{
+#if LJ_BE
+  v = lj_bswap64(v);
+#endif
+  memcpy(w, &v, 8);
+  return w+8;
+}
+
+/* -- Encoder ------------------------------------------------------------- */
+
+/* Encoder state. */
+typedef struct SerEnc {
+  lua_State *L;
+  SBuf *sb;		/* Output buffer. */
+  GCtab *dict;		/* String dictionary: string -> index. */
+  GCtab *visit;		/* Tables currently being encoded. */
+  uint32_t ndict;	/* Number of dictionary entries. */
+  uint32_t depth;	/* Current nesting depth. */
+} SerEnc;
+
+static void serialize_putuleb(SerEnc *se, uint32_t v)
+{
+  char *w = lj_buf_more(se->sb, 5);
+  setsbufP(se->sb, lj_strfmt_wuleb128(w, v));
+}
+
+static void serialize_putstr(SerEnc *se, GCstr *str, int iskey)
+{
+  SBuf *sb = se->sb;
+  MSize len = str->len;
+  cTValue *tv = lj_tab_getstr(se->dict, str);
+  char *w;
+  if (tv && tvisnumber(tv)) {
+    w = lj_buf_more(sb, 1+5);
+    *w++ = SER_TAG_DICT;
+    setsbufP(sb, lj_strfmt_wuleb128(w, (uint32_t)numberVint(tv)));
+    return;
+  }
+  w = lj_buf_more(sb, 5+len);
+  w = lj_strfmt_wuleb128(w, SER_TAG_STR+len);
+  setsbufP(sb, lj_buf_wmem(w, strdata(str), len));
+  if (iskey && se->ndict < LJ_MAX_SERDICT)
+    setintV(lj_tab_setstr(se->L, se->dict, str), (int32_t)se->ndict++);
+}
+
+static void serialize_put(SerEnc *se, cTValue *o, int iskey);
+
+static void serialize_puttab(SerEnc *se, cTValue *o)
+{
+  GCtab *t = tabV(o);
+  TValue *v;
+  MSize i, narray = 0, nhash = 0;
+  if (++se->depth > LJ_MAX_SERDEPTH)
+    lj_err_caller(se->L, LJ_ERR_BUFFER_DEPTH);
+  v = lj_tab_set(se->L, se->visit, o);
+  if (!tvisnil(v))
+    lj_err_caller(se->L, LJ_ERR_BUFFER_CYCLE);
+  setboolV(v, 1);
+  /* Count the trailing array part and the non-nil hash slots. */
+  if (t->asize > 1) {
+    narray = t->asize-1;
+    while (narray > 0 && tvisnil(arrayslot(t, narray))) narray--;
+  }
+  if (t->asize > 0 && !tvisnil(arrayslot(t, 0))) nhash++;
+  if (t->hmask > 0) {
+    Node *node = noderef(t->node);
+    for (i = 0; i <= t->hmask; i++)
+      nhash += !tvisnil(&node[i].val);
+  }
+  lj_buf_putb(se->sb, SER_TAG_TAB);
+  serialize_putuleb(se, narray);
+  serialize_putuleb(se, nhash);
+  for (i = 1; i <= narray; i++)
+    serialize_put(se, arrayslot(t, i), 0);
+  if (t->asize > 0 && !tvisnil(arrayslot(t, 0))) {
+    TValue k;
+    setintV(&k, 0);
+    serialize_put(se, &k, 1);
+    serialize_put(se, arrayslot(t, 0), 0);
+  }
+  if (t->hmask > 0) {
+    Node *node = noderef(t->node);
+    for (i = 0; i <= t->hmask; i++) {
+      Node *n = &node[i];
+      if (!tvisnil(&n->val)) {
+	serialize_put(se, &n->key, 1);
+	serialize_put(se, &n->val, 0);
+      }
+    }
+  }
+  /* The visit table may have been resized, so look up the key again. */
+  setnilV(lj_tab_set(se->L, se->visit, o));
+  se->depth--;
+}
+
+static void serialize_put(SerEnc *se, cTValue *o, int iskey)
+{
+  SBuf *sb = se->sb;
+  if (LJ_LIKELY(tvisstr(o))) {
+    serialize_putstr(se, strV(o), iskey);
+  } else if (tvisint(o)) {
+    char *w = lj_buf_more(sb, 1+4);
+    *w++ = SER_TAG_INT;
+    setsbufP(sb, serialize_wu32(w, (uint32_t)intV(o)));
+  } else if (tvisnum(o)) {
+    lua_Number n = numV(o);
+    int32_t k = lj_num2int(n);
+    char *w = lj_buf_more(sb, 1+8);
+    if (n == (lua_Number)k && !tvismzero(o)) {  /* Compact integers. */
+      *w++ = SER_TAG_INT;
+      w = serialize_wu32(w, (uint32_t)k);
+    } else {
+      *w++ = SER_TAG_NUM;
+      w = serialize_wu64(w, o->u64);
+    }
+    setsbufP(sb, w);
+  } else if (tvispri(o)) {
+    lj_buf_putb(sb, tvisnil(o) ? SER_TAG_NIL :
+		    tvisfalse(o) ? SER_TAG_FALSE : SER_TAG_TRUE);
+  } else if (tvistab(o)) {
+    serialize_puttab(se, o);
+#if LJ_HASFFI
+  } else if (tviscdata(o)) {
+    GCcdata *cd = cdataV(o);
+    uint64_t *p = (uint64_t *)cdataptr(cd);
+    char *w = lj_buf_more(sb, 1+16);
+    if (cd->ctypeid == CTID_INT64 || cd->ctypeid == CTID_UINT64) {
+      *w++ = cd->ctypeid == CTID_INT64 ? SER_TAG_INT64 : SER_TAG_UINT64;
+      w = serialize_wu64(w, p[0]);
+    } else if (cd->ctypeid == CTID_COMPLEX_DOUBLE) {
+      *w++ = SER_TAG_COMPLEX;
+      w = serialize_wu64(w, p[0]);
+      w = serialize_wu64(w, p[1]);
+    } else {
+      goto badenc;
+    }
+    setsbufP(sb, w);
+#endif
+  } else {
+#if LJ_HASFFI
+  badenc:
+#endif
+    lj_err_callerv(se->L, LJ_ERR_BUFFER_BADENC, lj_typename(o));
+  }
+}
+
+/* Serialize an object and append it to the buffer. */
+SBuf *lj_serialize_put(SBuf *sb, cTValue *o)
+{
+  SerEnc se;
+  se.L = sbufL(sb);
+  se.sb = sb;
+  /* NOBARRIER: No GC step can happen before both tables are dead. */
+  se.dict = lj_tab_new(se.L, 0, 0);
+  se.visit = lj_tab_new(se.L, 0, 0);
+  se.ndict = 0;
+  se.depth = 0;
+  serialize_put(&se, o, 0);
+  return sb;
+}
+
+/* -- Decoder ------------------------------------------------------------- */
+
+/* Decoder state. */
+typedef struct SerDec {
+  lua_State *L;
+  const char *r;	/* Read pointer. */
+  const char *e;	/* End of input. */
+  GCtab *dict;		/* String dictionary: index -> string. */
+  uint32_t ndict;	/* Number of dictionary entries. */
+  uint32_t depth;	/* Current nesting depth. */
+} SerDec;
+
+static LJ_AINLINE void serialize_need(SerDec *sd, MSize n)
+{
+  if (LJ_UNLIKELY((MSize)(sd->e - sd->r) < n))
+    lj_err_caller(sd->L, LJ_ERR_BUFFER_EOB);
+}
+
+static uint32_t serialize_getuleb(SerDec *sd)
+{
+  uint32_t v = 0, c;
+  int sh = 0;
+  do {
+    serialize_need(sd, 1);
+    c = *(const uint8_t *)sd->r++;
+    if (sh < 32) v |= (c & 0x7f) << sh;
+    sh += 7;
+  } while (c >= 0x80);
+  return v;
+}
+
+static uint64_t serialize_getu64(SerDec *sd)
+{
+  uint64_t v;
+  serialize_need(sd, 8);
+  memcpy(&v, sd->r, 8);
+  sd->r += 8;
+#if LJ_BE
+  v = lj_bswap64(v);
+#endif
+  return v;
+}
+
+static void serialize_get(SerDec *sd, TValue *o, int iskey)
+{
+  lua_State *L = sd->L;
+  uint32_t tp = serialize_getuleb(sd);
+  if (LJ_LIKELY(tp >= SER_TAG_STR)) {
+    MSize len = tp - SER_TAG_STR;
+    GCstr *str;
+    serialize_need(sd, len);
+    str = lj_str_new(L, sd->r, len);
+    sd->r += len;
+    setstrV(L, o, str);
+    if (iskey && sd->ndict < LJ_MAX_SERDICT) {
+      setstrV(L, lj_tab_setint(L, sd->dict, (int32_t)sd->ndict), str);
+      sd->ndict++;
+    }
+    return;
+  }
+  switch (tp) {
+  case SER_TAG_NIL: setnilV(o); break;
+  case SER_TAG_FALSE: setboolV(o, 0); break;
+  case SER_TAG_TRUE: setboolV(o, 1); break;
+  case SER_TAG_INT: {
+    uint32_t v;
+    serialize_need(sd, 4);
+    memcpy(&v, sd->r, 4);
+    sd->r += 4;
+#if LJ_BE
+    v = lj_bswap(v);
+#endif
+    setintV(o, (int32_t)v);
+    break;
+    }
+  case SER_TAG_NUM:
+    o->u64 = serialize_getu64(sd);
+    if (LJ_UNLIKELY(tvisnan(o))) setnanV(o);  /* Canonicalize NaNs. */
+    break;
+  case SER_TAG_TAB: {
+    uint32_t narray = serialize_getuleb(sd);
+    uint32_t nhash = serialize_getuleb(sd);
+    uint32_t i;
+    GCtab *t;
+    /* Every value takes at least one byte. Avoid bogus preallocations. */
+    if (narray > (MSize)(sd->e - sd->r) ||
+	nhash > (MSize)(sd->e - sd->r)/2)
+      lj_err_caller(L, LJ_ERR_BUFFER_EOB);
+    if (++sd->depth > LJ_MAX_SERDEPTH)
+      lj_err_caller(L, LJ_ERR_BUFFER_DEPTH);
+    t = lj_tab_new(L, narray ? narray+1 : 0, hsize2hbits(nhash));
+    /* NOBARRIER: The table is new (marked white). */
+    settabV(L, o, t);
+    for (i = 1; i <= narray; i++)
+      serialize_get(sd, arrayslot(t, i), 0);
+    for (i = 0; i < nhash; i++) {
+      TValue k;
+      serialize_get(sd, &k, 1);
+      serialize_get(sd, lj_tab_set(L, t, &k), 0);
+    }
+    sd->depth--;
+    break;
+    }
+  case SER_TAG_DICT: {
+    uint32_t idx = serialize_getuleb(sd);
+    if (idx >= sd->ndict)
+      lj_err_callerv(L, LJ_ERR_BUFFER_BADDEC, tp);
+    copyTV(L, o, lj_tab_getint(sd->dict, (int32_t)idx));
+    break;
+    }
+#if LJ_HASFFI
+  case SER_TAG_INT64: case SER_TAG_UINT64: case SER_TAG_COMPLEX: {
+    MSize sz = tp == SER_TAG_COMPLEX ? 16 : 8;
+    GCcdata *cd;
+    serialize_need(sd, sz);
+    cd = lj_cdata_new_(L, tp == SER_TAG_INT64 ? CTID_INT64 :
+			  tp == SER_TAG_UINT64 ? CTID_UINT64 :
+			  CTID_COMPLEX_DOUBLE, sz);
+    ((uint64_t *)cdataptr(cd))[0] = serialize_getu64(sd);
+    if (sz == 16)
+      ((uint64_t *)cdataptr(cd))[1] = serialize_getu64(sd);
+    setcdataV(L, o, cd);
+    break;
+    }
+#endif
+  default:
+    lj_err_callerv(L, LJ_ERR_BUFFER_BADDEC, tp);
+    break;
+  }
+}
+
+/* Deserialize one object from [r, e) to stack slot o.
+** Returns the new read pointer.
+*/
+const char *lj_serialize_get(lua_State *L, const char *r, const char *e,
+			     TValue *o)
+{
+  SerDec sd;
+#if LJ_HASFFI
+  /* The cdata tags need the FFI state. Load it before decoding starts.
+  ** Loading it later could run a GC step or reallocate the stack while
+  ** partially decoded objects are only referenced from C.
+  */
+  if (!ctype_ctsG(G(L))) {
+    ptrdiff_t oldtop = savestack(L, L->top), oofs = savestack(L, o);
+    luaopen_ffi(L);  /* Load FFI library on-demand. */
+    L->top = restorestack(L, oldtop);
+    o = restorestack(L, oofs);
+  }
+#endif
+  sd.L = L;
+  sd.r = r;
+  sd.e = e;
+  /* NOBARRIER: No GC step can happen until the decoded object is done. */
+  sd.dict = lj_tab_new(L, 0, 0);
+  sd.ndict = 0;
+  sd.depth = 0;
+  serialize_get(&sd, o, 0);
+  return sd.r;
+}
@@ -0,0 +1,16 @@
+/*
+** Object de/serialization.
+** Copyright (C) 2005-2020 Mike Pall. See Copyright Notice in luajit.h
+*/
+
+#ifndef _LJ_SERIALIZE_H
+#define _LJ_SERIALIZE_H
+
+#include "lj_obj.h"
+#include "lj_buf.h"
+
+LJ_FUNC SBuf *lj_serialize_put(SBuf *sb, cTValue *o);
+LJ_FUNC const char *lj_serialize_get(lua_State *L, const char *r,
+				     const char *e, TValue *o);
+
+#endif
@@ -170,6 +170,8 @@ static void snapshot_stack(jit_State *J, SnapShot *snap, MSize nsnapmap)
   snap->ref = (IRRef1)J->cur.nins;
   snap->nslots = (uint8_t)nslots;
   snap->count = 0;
+  snap->flags = 0;
+  snap->nexit = 0;
   J->cur.nsnapmap = (uint32_t)(nsnapmap + nent);
 }
 
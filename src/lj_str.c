@@ -215,9 +215,13 @@ void lj_str_resize(lua_State *L, MSize newmask)
 }
 
 #if LUAJIT_SECURITY_STRHASH
+static GCstr *lj_str_intern_(lua_State *L, const char *str, MSize len,
+			     GCstr *pre);
+
 /* Rehash and rechain all strings in a chain. */
 static LJ_NOINLINE GCstr *lj_str_rehash_chain(lua_State *L, StrHash hashc,
-					      const char *str, MSize len)
+					      const char *str, MSize len,
+					      GCstr *pre)
 {
   global_State *g = G(L);
   int ow = g->gc.state == GCSsweepstring ? otherwhite(g) : 0;  /* Sweeping? */
@@ -258,7 +262,7 @@ static LJ_NOINLINE GCstr *lj_str_rehash_chain(lua_State *L, StrHash hashc,
     o = next;
   }
   /* Try to insert the pending string again. */
-  return lj_str_new(L, str, len);
+  return lj_str_intern_(L, str, len, pre);
 }
 #endif
 
@@ -271,11 +275,11 @@ static LJ_NOINLINE GCstr *lj_str_rehash_chain(lua_State *L, StrHash hashc,
 #define STRID_RESEED_INTERVAL	0
 #endif
 
-/* Allocate a new string and add to string interning table. */
+/* Allocate a new string (unless pre-allocated) and add to interning table. */
 static GCstr *lj_str_alloc(lua_State *L, const char *str, MSize len,
-			   StrHash hash, int hashalg)
+			   StrHash hash, int hashalg, GCstr *pre)
 {
-  GCstr *s = lj_mem_newt(L, lj_str_size(len), GCstr);
+  GCstr *s = pre ? pre : lj_mem_newt(L, lj_str_size(len), GCstr);
   global_State *g = G(L);
   uintptr_t u;
   newwhite(g, s);
@@ -296,9 +300,11 @@ static GCstr *lj_str_alloc(lua_State *L, const char *str, MSize len,
 #endif
   s->reserved = 0;
   s->hashalg = (uint8_t)hashalg;
-  /* Clear last 4 bytes of allocated memory. Implies zero-termination, too. */
-  *(uint32_t *)(strdatawr(s)+(len & ~(MSize)3)) = 0;
-  memcpy(strdatawr(s), str, len);
+  if (!pre) {
+    /* Clear last 4 bytes of allocated memory. Implies zero-termination. */
+    *(uint32_t *)(strdatawr(s)+(len & ~(MSize)3)) = 0;
+    memcpy(strdatawr(s), str, len);
+  }
   /* Add to string hash table. */
   hash &= g->str.mask;
   u = gcrefu(g->str.tab[hash]);
@@ -310,49 +316,93 @@ static GCstr *lj_str_alloc(lua_State *L, const char *str, MSize len,
   return s;  /* Return newly interned string. */
 }
 
-/* Intern a string and return string object. */
-GCstr *lj_str_new(lua_State *L, const char *str, size_t lenx)
+/* Intern a string. Either use or free the optional pre-allocated string. */
+static GCstr *lj_str_intern_(lua_State *L, const char *str, MSize len,
+			     GCstr *pre)
 {
   global_State *g = G(L);
-  if (lenx-1 < LJ_MAX_STR-1) {
-    MSize len = (MSize)lenx;
-    StrHash hash = hash_sparse(g->str.seed, str, len);
-    MSize coll = 0;
-    int hashalg = 0;
-    /* Check if the string has already been interned. */
-    GCobj *o = gcref(g->str.tab[hash & g->str.mask]);
+  StrHash hash = hash_sparse(g->str.seed, str, len);
+  MSize coll = 0;
+  int hashalg = 0;
+  /* Check if the string has already been interned. */
+  GCobj *o = gcref(g->str.tab[hash & g->str.mask]);
 #if LUAJIT_SECURITY_STRHASH
-    if (LJ_UNLIKELY((uintptr_t)o & 1)) {  /* Secondary hash for this chain? */
-      hashalg = 1;
-      hash = hash_dense(g->str.seed, hash, str, len);
-      o = (GCobj *)(gcrefu(g->str.tab[hash & g->str.mask]) & ~(uintptr_t)1);
-    }
+  if (LJ_UNLIKELY((uintptr_t)o & 1)) {  /* Secondary hash for this chain? */
+    hashalg = 1;
+    hash = hash_dense(g->str.seed, hash, str, len);
+    o = (GCobj *)(gcrefu(g->str.tab[hash & g->str.mask]) & ~(uintptr_t)1);
+  }
 #endif
-    while (o != NULL) {
-      GCstr *sx = gco2str(o);
-      if (sx->hash == hash && sx->len == len) {
-	if (memcmp(str, strdata(sx), len) == 0) {
-	  if (isdead(g, o)) flipwhite(o);  /* Resurrect if dead. */
-	  return sx;  /* Return existing string. */
-	}
-	coll++;
+  while (o != NULL) {
+    GCstr *sx = gco2str(o);
+    if (sx->hash == hash && sx->len == len) {
+      if (memcmp(str, strdata(sx), len) == 0) {
+	if (isdead(g, o)) flipwhite(o);  /* Resurrect if dead. */
+	if (pre) lj_mem_free(g, pre, lj_str_size(len));
+	return sx;  /* Return existing string. */
       }
       coll++;
-      o = gcnext(o);
     }
+    coll++;
+    o = gcnext(o);
+  }
 #if LUAJIT_SECURITY_STRHASH
-    /* Rehash chain if there are too many collisions. */
-    if (LJ_UNLIKELY(coll > LJ_STR_MAXCOLL) && !hashalg) {
-      return lj_str_rehash_chain(L, hash, str, len);
-    }
+  /* Rehash chain if there are too many collisions. */
+  if (LJ_UNLIKELY(coll > LJ_STR_MAXCOLL) && !hashalg) {
+    return lj_str_rehash_chain(L, hash, str, len, pre);
+  }
 #endif
-    /* Otherwise allocate a new string. */
-    return lj_str_alloc(L, str, len, hash, hashalg);
+  /* Otherwise allocate a new string. */
+  return lj_str_alloc(L, str, len, hash, hashalg, pre);
+}
+
+/* Intern a string and return string object. */
+GCstr *lj_str_new(lua_State *L, const char *str, size_t lenx)
+{
+  if (lenx-1 < LJ_MAX_STR-1) {
+    return lj_str_intern_(L, str, (MSize)lenx, NULL);
   } else {
     if (lenx)
       lj_err_msg(L, LJ_ERR_STROV);
-    return &g->strempty;
+    return &G(L)->strempty;
+  }
+}
+
+/*
+** Allocate an uninterned string object with room for len > 0 bytes. This
+** allows building long strings in place, without an extra copy. The caller
+** must fill in the string data before calling lj_str_intern(). There must
+** be no GC step in between.
+*/
+GCstr *lj_str_prealloc(lua_State *L, MSize len)
+{
+  GCstr *s;
+  if (len >= LJ_MAX_STR)
+    lj_err_msg(L, LJ_ERR_STROV);
+  s = lj_mem_newt(L, lj_str_size(len), GCstr);
+  s->len = len;
+  /* Clear last 4 bytes of allocated memory. Implies zero-termination, too. */
+  *(uint32_t *)(strdatawr(s)+(len & ~(MSize)3)) = 0;
+  return s;
+}
+
+/*
+** Intern a pre-allocated string, after trimming it to len <= s->len.
+** May free it and return an existing string instead.
+*/
+GCstr *lj_str_intern(lua_State *L, GCstr *s, MSize len)
+{
+  if (LJ_UNLIKELY(len != s->len)) {
+    global_State *g = G(L);
+    if (len == 0) {
+      lj_mem_free(g, s, lj_str_size(s->len));
+      return &g->strempty;
+    }
+    s = (GCstr *)lj_mem_realloc(L, s, lj_str_size(s->len), lj_str_size(len));
+    s->len = len;
+    memset(strdatawr(s)+len, 0, 4 - (len & 3));  /* Clear padding. */
   }
+  return lj_str_intern_(L, strdata(s), len, s);
 }
 
 void LJ_FASTCALL lj_str_free(global_State *g, GCstr *s)
@@ -19,6 +19,8 @@ LJ_FUNC int lj_str_haspattern(GCstr *s);
 /* String interning. */
 LJ_FUNC void lj_str_resize(lua_State *L, MSize newmask);
 LJ_FUNCA GCstr *lj_str_new(lua_State *L, const char *str, size_t len);
+LJ_FUNC GCstr *lj_str_prealloc(lua_State *L, MSize len);
+LJ_FUNC GCstr *lj_str_intern(lua_State *L, GCstr *s, MSize len);
 LJ_FUNC void LJ_FASTCALL lj_str_free(global_State *g, GCstr *s);
 LJ_FUNC void LJ_FASTCALL lj_str_init(lua_State *L);
 #define lj_str_freetab(g) \
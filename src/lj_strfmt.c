@@ -8,12 +8,17 @@
 #define lj_strfmt_c
 #define LUA_CORE
 
+#include "lauxlib.h"
+
 #include "lj_obj.h"
+#include "lj_err.h"
 #include "lj_buf.h"
 #include "lj_str.h"
+#include "lj_meta.h"
 #include "lj_state.h"
 #include "lj_char.h"
 #include "lj_strfmt.h"
+#include "lj_lib.h"
 
 /* -- Format parser ------------------------------------------------------- */
 
@@ -399,6 +404,101 @@ GCstr * LJ_FASTCALL lj_strfmt_obj(lua_State *L, cTValue *o)
   }
 }
 
+/* -- Formatting of function arguments ----------------------------------- */
+
+/* Emulate tostring() inline. */
+static GCstr *strfmt_argstr(lua_State *L, int arg, int retry)
+{
+  TValue *o = L->base+arg-1;
+  cTValue *mo;
+  lj_assertL(o < L->top, "bad usage");  /* Caller already checks for existence. */
+  if (LJ_LIKELY(tvisstr(o)))
+    return strV(o);
+  if (retry >= 0 && !tvisnil(mo = lj_meta_lookup(L, o, MM_tostring))) {
+    copyTV(L, L->top++, mo);
+    copyTV(L, L->top++, o);
+    lua_call(L, 1, 1);
+    o = L->base+arg-1;  /* Stack may have been reallocated. */
+    copyTV(L, o, --L->top);
+    if (retry == 0)
+      return NULL;  /* Buffer may be overwritten, retry. */
+    if (tvisstr(o))
+      return strV(o);
+  }
+  return lj_strfmt_obj(L, o);
+}
+
+/* Format the arguments following the format string at stack slot arg.
+**
+** retry = 0: first pass into a temporary buffer. Returns 1 if a __tostring
+**   metamethod has been called, which may have clobbered the buffer. The
+**   converted arguments are stored back to the stack.
+** retry < 0: second pass after the above. Metamethods are not called again.
+** retry > 0: a stable buffer owned by the caller. Metamethods are called
+**   inline and their results are used right away. Always returns 0.
+*/
+int lj_strfmt_putarg(lua_State *L, SBuf *sb, int arg, int retry)
+{
+  int top = (int)(L->top - L->base);
+  GCstr *fmt = lj_lib_checkstr(L, arg);
+  FormatState fs;
+  SFormat sf;
+  int res = 0;
+  lj_strfmt_init(&fs, strdata(fmt), fmt->len);
+  while ((sf = lj_strfmt_parse(&fs)) != STRFMT_EOF) {
+    if (sf == STRFMT_LIT) {
+      lj_buf_putmem(sb, fs.str, fs.len);
+    } else if (sf == STRFMT_ERR) {
+      lj_err_callerv(L, LJ_ERR_STRFMT, strdata(lj_str_new(L, fs.str, fs.len)));
+    } else {
+      if (++arg > top)
+	luaL_argerror(L, arg, lj_obj_typename[0]);
+      switch (STRFMT_TYPE(sf)) {
+      case STRFMT_INT:
+	if (tvisint(L->base+arg-1)) {
+	  int32_t k = intV(L->base+arg-1);
+	  if (sf == STRFMT_INT)
+	    lj_strfmt_putint(sb, k);  /* Shortcut for plain %d. */
+	  else
+	    lj_strfmt_putfxint(sb, sf, k);
+	} else {
+	  lj_strfmt_putfnum_int(sb, sf, lj_lib_checknum(L, arg));
+	}
+	break;
+      case STRFMT_UINT:
+	if (tvisint(L->base+arg-1))
+	  lj_strfmt_putfxint(sb, sf, intV(L->base+arg-1));
+	else
+	  lj_strfmt_putfnum_uint(sb, sf, lj_lib_checknum(L, arg));
+	break;
+      case STRFMT_NUM:
+	lj_strfmt_putfnum(sb, sf, lj_lib_checknum(L, arg));
+	break;
+      case STRFMT_STR: {
+	GCstr *str = strfmt_argstr(L, arg, retry);
+	if (str == NULL)
+	  res = 1;
+	else if ((sf & STRFMT_T_QUOTED))
+	  lj_strfmt_putquoted(sb, str);  /* No formatting. */
+	else
+	  lj_strfmt_putfstr(sb, sf, str);
+	break;
+	}
+      case STRFMT_CHAR:
+	lj_strfmt_putfchar(sb, sf, lj_lib_checkint(L, arg));
+	break;
+      case STRFMT_PTR:  /* No formatting. */
+	lj_strfmt_putptr(sb, lj_obj_ptr(L->base+arg-1));
+	break;
+      default:
+	lj_assertL(0, "bad string format type");
+	break;
+      }
+    }
+  }
+  return res;
+}
+
 /* -- Internal string formatting ------------------------------------------ */
 
 /*
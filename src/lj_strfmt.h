@@ -72,6 +72,22 @@ typedef enum FormatType {
 #define STRFMT_MAXBUF_NUM	32  /* Must correspond with STRFMT_G14. */
 #define STRFMT_MAXBUF_PTR	(2+2*sizeof(ptrdiff_t))  /* "0x" + hex ptr. */
 
+/* Cached powers of ten for fast number conversions. */
+#define STRFMT_POW10_KMIN	(-308)
+#define STRFMT_POW10_N		80
+
+LJ_DATA const uint64_t lj_strfmt_pow10_m[STRFMT_POW10_N];
+LJ_DATA const int16_t lj_strfmt_pow10_e[STRFMT_POW10_N];
+
+/* Upper 64 bits of the 128 bit product x*y, rounded to nearest. */
+static LJ_AINLINE uint64_t lj_strfmt_mulhi(uint64_t x, uint64_t y)
+{
+  uint64_t xh = x >> 32, xl = (uint32_t)x, yh = y >> 32, yl = (uint32_t)y;
+  uint64_t hl = xh*yl, lh = xl*yh;
+  uint64_t t = ((xl*yl) >> 32) + (uint32_t)hl + (uint32_t)lh + 0x80000000u;
+  return xh*yh + (hl >> 32) + (lh >> 32) + (t >> 32);
+}
+
 /* Format parser. */
 LJ_FUNC SFormat LJ_FASTCALL lj_strfmt_parse(FormatState *fs);
 
@@ -114,6 +130,9 @@ LJ_FUNC GCstr * LJ_FASTCALL lj_strfmt_char(lua_State *L, int c);
 #endif
 LJ_FUNC GCstr * LJ_FASTCALL lj_strfmt_obj(lua_State *L, cTValue *o);
 
+/* Formatting of function arguments. */
+LJ_FUNC int lj_strfmt_putarg(lua_State *L, SBuf *sb, int arg, int retry);
+
 /* Internal string formatting. */
 LJ_FUNC const char *lj_strfmt_pushvf(lua_State *L, const char *fmt,
 				     va_list argp);
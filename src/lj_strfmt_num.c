@@ -57,6 +57,63 @@ static uint32_t ndigits_dec_threshold[] = {
   9999999U, 99999999U, 999999999U, 0xffffffffU
 };
 
+/*
+** Cached powers 10^k for k = -308, -300, ..., 324, as normalized 64 bit
+** significands (rounded to nearest) and their binary exponents.
+** Also used by the fast path for decimal conversions in lj_strscan.c.
+*/
+LJ_DATADEF const uint64_t lj_strfmt_pow10_m[STRFMT_POW10_N] = {
+  U64x(e61acf03,3d1a45df), U64x(ab70fe17,c79ac6ca),
+  U64x(ff77b1fc,bebcdc4f), U64x(be5691ef,416bd60c),
+  U64x(8dd01fad,907ffc3c), U64x(d3515c28,31559a83),
+  U64x(9d71ac8f,ada6c9b5), U64x(ea9c2277,23ee8bcb),
+  U64x(aecc4991,4078536d), U64x(823c1279,5db6ce57),
+  U64x(c2109436,4dfb5637), U64x(9096ea6f,3848984f),
+  U64x(d77485cb,25823ac7), U64x(a086cfcd,97bf97f4),
+  U64x(ef340a98,172aace5), U64x(b23867fb,2a35b28e),
+  U64x(84c8d4df,d2c63f3b), U64x(c5dd4427,1ad3cdba),
+  U64x(936b9fce,bb25c996), U64x(dbac6c24,7d62a584),
+  U64x(a3ab6658,0d5fdaf6), U64x(f3e2f893,dec3f126),
+  U64x(b5b5ada8,aaff80b8), U64x(87625f05,6c7c4a8b),
+  U64x(c9bcff60,34c13053), U64x(964e858c,91ba2655),
+  U64x(dff97724,70297ebd), U64x(a6dfbd9f,b8e5b88f),
+  U64x(f8a95fcf,88747d94), U64x(b9447093,8fa89bcf),
+  U64x(8a08f0f8,bf0f156b), U64x(cdb02555,653131b6),
+  U64x(993fe2c6,d07b7fac), U64x(e45c10c4,2a2b3b06),
+  U64x(aa242499,697392d3), U64x(fd87b5f2,8300ca0e),
+  U64x(bce50864,92111aeb), U64x(8cbccc09,6f5088cc),
+  U64x(d1b71758,e219652c), U64x(9c400000,00000000),
+  U64x(e8d4a510,00000000), U64x(ad78ebc5,ac620000),
+  U64x(813f3978,f8940984), U64x(c097ce7b,c90715b3),
+  U64x(8f7e32ce,7bea5c70), U64x(d5d238a4,abe98068),
+  U64x(9f4f2726,179a2245), U64x(ed63a231,d4c4fb27),
+  U64x(b0de6538,8cc8ada8), U64x(83c7088e,1aab65db),
+  U64x(c45d1df9,42711d9a), U64x(924d692c,a61be758),
+  U64x(da01ee64,1a708dea), U64x(a26da399,9aef774a),
+  U64x(f209787b,b47d6b85), U64x(b454e4a1,79dd1877),
+  U64x(865b8692,5b9bc5c2), U64x(c83553c5,c8965d3d),
+  U64x(952ab45c,fa97a0b3), U64x(de469fbd,99a05fe3),
+  U64x(a59bc234,db398c25), U64x(f6c69a72,a3989f5c),
+  U64x(b7dcbf53,54e9bece), U64x(88fcf317,f22241e2),
+  U64x(cc20ce9b,d35c78a5), U64x(98165af3,7b2153df),
+  U64x(e2a0b5dc,971f303a), U64x(a8d9d153,5ce3b396),
+  U64x(fb9b7cd9,a4a7443c), U64x(bb764c4c,a7a44410),
+  U64x(8bab8eef,b6409c1a), U64x(d01fef10,a657842c),
+  U64x(9b10a4e5,e9913129), U64x(e7109bfb,a19c0c9d),
+  U64x(ac2820d9,623bf429), U64x(80444b5e,7aa7cf85),
+  U64x(bf21e440,03acdd2d), U64x(8e679c2f,5e44ff8f),
+  U64x(d433179d,9c8cb841), U64x(9e19db92,b4e31ba9)
+};
+
+LJ_DATADEF const int16_t lj_strfmt_pow10_e[STRFMT_POW10_N] = {
+  -1087, -1060, -1034, -1007, -980, -954, -927, -901, -874, -847, -821, -794,
+  -768, -741, -715, -688, -661, -635, -608, -582, -555, -529, -502, -475,
+  -449, -422, -396, -369, -343, -316, -289, -263, -236, -210, -183, -157,
+  -130, -103, -77, -50, -24, 3, 30, 56, 83, 109, 136, 162, 189, 216, 242, 269,
+  295, 322, 348, 375, 402, 428, 455, 481, 508, 534, 561, 588, 614, 641, 667,
+  694, 720, 747, 774, 800, 827, 853, 880, 907, 933, 960, 986, 1013
+};
+
 /* -- Helper functions ---------------------------------------------------- */
 
 /* Compute the number of digits in the decimal representation of x. */
@@ -263,6 +320,165 @@ static int nd_similar(uint32_t* nd, uint32_t ndhi, uint32_t* ref, MSize hilen,
   return !memcmp(nd9, ref9, prec) && (nd9[prec] < '5') == (ref9[prec] < '5');
 }
 
+/* -- Fast conversion with 64 bit arithmetic ------------------------------ */
+
+/*
+** Most conversions to at most 17 significant digits can be done with a
+** 64 bit approximation of n*10^k (similar to Grisu). The error of this
+** approximation is below one unit in the last place. The digits are only
+** used if this error cannot affect the rounding decision. Otherwise the
+** caller falls back to the exact conversion in "nd" format.
+*/
+
+/*
+** Convert the absolute value of a finite, non-zero number to decimal digits.
+** For %e and %g, prec+1 significant digits are generated. For %f, the
+** digits up to 10^-prec are generated. Returns the number of digits and
+** the decimal exponent of the first digit, or 0 if the result is uncertain.
+*/
+static MSize fnum_fastdigits(uint64_t u, SFormat sf, MSize prec,
+			     char *d, int32_t *pnde)
+{
+  uint64_t f = u & U64x(000fffff,ffffffff), one, rest, tenk, unit = 1;
+  int32_t e = (int32_t)((u >> 52) & 0x7ff), k, nde;
+  uint32_t ip, div = 1, sh;
+  MSize nd = 0, nreq, kappa, i;
+  /* Normalize, so that abs(n) == f*2^e and bit 63 of f is set. */
+  if (e) {
+    f = (f | U64x(00100000,00000000)) << 11;
+    e -= 1075 + 11;
+  } else {
+    sh = (uint32_t)(f >> 32) ? 31-lj_fls((uint32_t)(f >> 32)) :
+			       63-lj_fls((uint32_t)f);
+    f <<= sh;
+    e = -1074 - (int32_t)sh;
+  }
+  /* Pick 10^k, such that the binary exponent of f*10^k is in [-60, -32]. */
+  k = (-61 - e) * 78913;
+  k = ((k + (1<<18)-1) >> 18) - STRFMT_POW10_KMIN + 7;
+  f = lj_strfmt_mulhi(f, lj_strfmt_pow10_m[k >> 3]);
+  sh = (uint32_t)-(e + lj_strfmt_pow10_e[k >> 3] + 64);
+  lj_assertX(sh >= 32 && sh <= 60, "bad shift %d", sh);
+  k = (k >> 3) * 8 + STRFMT_POW10_KMIN;
+  /* Split into the integer part and fraction of abs(n)*10^k. */
+  one = (uint64_t)1 << sh;
+  ip = (uint32_t)(f >> sh);
+  f &= one - 1;
+  kappa = ndigits_dec(ip);
+  for (i = 1; i < kappa; i++) div *= 10;
+  nde = (int32_t)kappa - 1 - k;
+  nreq = (sf & STRFMT_T_FP_E) ? prec + 1 : (MSize)(nde + 1) + prec;
+  if ((int32_t)nreq <= 0 || nreq > 17) return 0;
+  /* Generate the digits of the integer part. */
+  for (;;) {
+    d[nd++] = (char)('0' + ip / div);
+    ip %= div;
+    if (nd == nreq || !--kappa) break;
+    div /= 10;
+  }
+  if (nd == nreq) {
+    rest = ((uint64_t)ip << sh) + f;
+    tenk = (uint64_t)div << sh;
+  } else {
+    /* Generate the digits of the fraction, as long as they are reliable. */
+    do {
+      if (f <= unit) return 0;
+      f *= 10;
+      unit *= 10;
+      d[nd++] = (char)('0' + (f >> sh));
+      f &= one - 1;
+    } while (nd < nreq);
+    rest = f;
+    tenk = one;
+  }
+  /* Round half up, unless the error might cross the rounding boundary. */
+  if (unit >= tenk || tenk - unit <= unit) return 0;
+  if (tenk - rest > rest && tenk - 2*rest > 2*unit) {
+    /* Round down. */
+  } else if (rest > unit && tenk - (rest - unit) <= rest - unit) {
+    /* Round up. */
+    for (i = nd-1; ; i--) {
+      if (d[i] != '9') { d[i]++; break; }
+      d[i] = '0';
+      if (!i) { d[0] = '1'; nde++; break; }
+    }
+  } else {
+    return 0;
+  }
+  *pnde = nde;
+  return nd;
+}
+
+/* Write formatted floating-point number for %e, %f or %g using the fast
+** conversion. Returns NULL if the exact conversion must be used instead.
+*/
+static char *lj_strfmt_wfnum_fast(SBuf *sb, SFormat sf, MSize prec,
+				  char prefix, uint64_t u, char *p)
+{
+  MSize width = STRFMT_WIDTH(sf), len, nd, nfrac = prec, i;
+  int32_t nde, expo = 0;
+  char d[17];
+  if (!(nd = fnum_fastdigits(u, sf, prec, d, &nde))) return NULL;
+  if ((sf & STRFMT_T_FP_E)) {
+    expo = 1;
+    if ((sf & STRFMT_T_FP_F)) {
+      /* %g - use %f style if the exponent is in range. */
+      if ((int32_t)prec >= nde && nde >= -4) {
+	nfrac = prec - nde;
+	expo = 0;
+      }
+      if (!(sf & STRFMT_F_ALT)) {
+	/* Strip trailing zeroes. */
+	while (nd > 1 && d[nd-1] == '0') nd--;
+	i = (MSize)((int32_t)nd - 1 - (expo ? 0 : nde));
+	if ((int32_t)i < (int32_t)nfrac) nfrac = (int32_t)i < 0 ? 0 : i;
+      }
+    }
+  }
+  len = nfrac + (prefix != 0) + ((nfrac | (sf & STRFMT_F_ALT)) != 0);
+  if (expo) {
+    uint32_t ae = (uint32_t)(nde < 0 ? -nde : nde);
+    len += 3 + ndigits_dec(ae) + (ae < 10);
+  } else {
+    len += nde >= 0 ? (MSize)nde + 1 : 1;
+  }
+  if (!p) p = lj_buf_more(sb, width > len ? width : len);
+  if (!(sf & (STRFMT_F_LEFT | STRFMT_F_ZERO))) {
+    while (width-- > len) *p++ = ' ';
+  }
+  if (prefix) *p++ = prefix;
+  if ((sf & (STRFMT_F_LEFT | STRFMT_F_ZERO)) == STRFMT_F_ZERO) {
+    while (width-- > len) *p++ = '0';
+  }
+#define FNUM_DIG(x)	((uint32_t)(x) < nd ? d[(x)] : '0')
+  if (expo) {
+    *p++ = d[0];
+    if ((nfrac | (sf & STRFMT_F_ALT))) {
+      *p++ = '.';
+      for (i = 1; i <= nfrac; i++) *p++ = FNUM_DIG(i);
+    }
+    *p++ = (sf & STRFMT_F_UPPER) ? 'E' : 'e';
+    if (nde < 0) {
+      *p++ = '-';
+      nde = -nde;
+    } else {
+      *p++ = '+';
+    }
+    if (nde < 10) *p++ = '0'; /* Always at least two digits of exponent. */
+    p = lj_strfmt_wint(p, nde);
+  } else {
+    if (nde < 0) *p++ = '0';
+    for (expo = 0; expo <= nde; expo++) *p++ = FNUM_DIG(expo);
+    if ((nfrac | (sf & STRFMT_F_ALT))) {
+      *p++ = '.';
+      for (i = 1; i <= nfrac; i++) *p++ = FNUM_DIG(nde + (int32_t)i);
+    }
+  }
+#undef FNUM_DIG
+  if ((sf & STRFMT_F_LEFT)) while (width-- > len) *p++ = ' ';
+  return p;
+}
+
 /* -- Formatted conversions to buffer ------------------------------------- */
 
 /* Write formatted floating-point number to either sb or p. */
@@ -360,6 +576,10 @@ static char *lj_strfmt_wfnum(SBuf *sb, SFormat sf, lua_Number n, char *p)
       prec--;
       prec ^= (uint32_t)((int32_t)prec >> 31);
     }
+    if (prec < 17 && n != 0) {
+      q = lj_strfmt_wfnum_fast(sb, sf, prec, prefix, t.u64, p);
+      if (q) return q;
+    }
     if ((sf & STRFMT_T_FP_E) && prec < 14 && n != 0) {
       /* Precision is sufficiently low that rescaling will probably work. */
       if ((ndebias = rescale_e[e >> 6])) {
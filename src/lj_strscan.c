@@ -10,6 +10,7 @@
 
 #include "lj_obj.h"
 #include "lj_char.h"
+#include "lj_strfmt.h"
 #include "lj_strscan.h"
 
 /* -- Scanning numbers ---------------------------------------------------- */
@@ -50,12 +51,16 @@
 ** handles simple integers on-the-fly. Otherwise, it dispatches to the
 ** base-specific parser. Hex and octal is straightforward.
 **
-** Decimal to binary conversion uses a fixed-length circular buffer in
-** base 100. Some simple cases are handled directly. For other cases, the
-** number in the buffer is up-scaled or down-scaled until the integer part
-** is in the proper range. Then the integer part is rounded and converted
-** to a double which is finally rescaled to the result. Denormals need
-** special treatment to prevent incorrect 'double rounding'.
+** Decimal numbers with up to 19 significant digits are first tried with
+** a fast path, which scales them with a 64 bit approximation of the power
+** of ten. It gives up, if the result is close to a rounding boundary.
+**
+** Otherwise, decimal to binary conversion uses a fixed-length circular
+** buffer in base 100. Some simple cases are handled directly. For other
+** cases, the number in the buffer is up-scaled or down-scaled until the
+** integer part is in the proper range. Then the integer part is rounded
+** and converted to a double which is finally rescaled to the result.
+** Denormals need special treatment to prevent incorrect 'double rounding'.
 */
 
 /* Definitions for circular decimal digit buffer (base 100 = 2 digits/byte). */
@@ -177,6 +182,73 @@ static StrScanFmt strscan_oct(const uint8_t *p, TValue *o,
   return fmt;
 }
 
+/* Powers of ten, which are exactly representable as doubles. */
+static const double strscan_pow10[] = {
+  1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12,
+  1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+/* Multiply normalized x by y and renormalize. Adjusts binary exponent. */
+#define STRSCAN_MULN(x, y, ex2) \
+  { x = lj_strfmt_mulhi(x, y); if (!(x >> 63)) x <<= 1, ex2--; }
+
+/*
+** Fast decimal conversion for up to 19 significant digits.
+** Returns 0, if the exact conversion needs to be used.
+**
+** If both the digits and the power of ten are exactly representable as
+** doubles, a single correctly rounded multiplication or division suffices.
+** Otherwise the digits are scaled with a 64 bit approximation of the
+** power of ten. The error of this approximation is a few units in the
+** last place, so the result is only used if it's not close to a halfway
+** point. Denormals and overflows are left to the exact conversion, too.
+*/
+static int strscan_dec_fast(const uint8_t *p, TValue *o,
+			    int32_t ex10, int32_t neg, uint32_t dig)
+{
+  uint64_t x = 0, y;
+  int32_t ex2, k;
+  uint32_t sh;
+  do {
+    if (*p == '.') p++;
+    x = x * 10 + (*p++ & 15);
+  } while (--dig);
+  if (x < U64x(00200000,00000000) && ex10 >= -22 && ex10 <= 22) {
+    double n = (double)(int64_t)x;
+    if (ex10 >= 0) n *= strscan_pow10[ex10]; else n /= strscan_pow10[-ex10];
+    o->n = neg ? -n : n;
+    return 1;
+  }
+  if (ex10 < STRFMT_POW10_KMIN || ex10 > 308) return 0;
+#if (defined(__GNUC__) || defined(__clang__)) && LJ_64
+  sh = (uint32_t)__builtin_clzll(x);
+#else
+  sh = (x>>32) ? 31-lj_fls((uint32_t)(x>>32)) : 63-lj_fls((uint32_t)x);
+#endif
+  x <<= sh;
+  ex2 = -(int32_t)sh + 64;
+  k = ex10 - STRFMT_POW10_KMIN;
+  if ((k & 7)) {  /* Multiply with exact 10^(k&7) first. */
+    y = (uint64_t)(uint32_t)strscan_pow10[k & 7];
+    sh = 31-lj_fls((uint32_t)y);
+    STRSCAN_MULN(x, y << (32+sh), ex2)
+    ex2 += 32 - (int32_t)sh;
+  }
+  STRSCAN_MULN(x, lj_strfmt_pow10_m[k >> 3], ex2)
+  ex2 += lj_strfmt_pow10_e[k >> 3];
+  /* Now abs(n) == x*2^ex2 with an error below 8 units of x. */
+  if ((uint32_t)((x & 0x7ff) - 0x400 + 8) <= 16) return 0;
+  y = (x >> 11) + ((x & 0x7ff) > 0x400);
+  ex2 += 11;
+  if ((y >> 53)) y >>= 1, ex2++;
+  ex2 += 52 + 1023;  /* Biased exponent of the result. */
+  if (ex2 <= 0 || ex2 >= 2047) return 0;
+  o->u64 = ((uint64_t)(uint32_t)neg << 63) | ((uint64_t)ex2 << 52) |
+	   (y & U64x(000fffff,ffffffff));
+  return 1;
+}
+#undef STRSCAN_MULN
+
 /* Parse decimal number. */
 static StrScanFmt strscan_dec(const uint8_t *p, TValue *o,
 			      StrScanFmt fmt, uint32_t opt,
@@ -184,6 +256,11 @@ static StrScanFmt strscan_dec(const uint8_t *p, TValue *o,
 {
   uint8_t xi[STRSCAN_DDIG], *xip = xi;
 
+  /* Fast path for non-integers with up to 19 significant digits. */
+  if (fmt < STRSCAN_INT && dig && dig <= 19 &&
+      strscan_dec_fast(p, o, ex10, neg, dig))
+    return fmt;
+
   if (dig) {
     uint32_t i = dig;
     if (i > STRSCAN_MAXDIG) {
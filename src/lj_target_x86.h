@@ -197,6 +197,10 @@ typedef struct {
 #define XV_f20f3a(o)	((uint32_t)(0x7be3c4 + (0x##o<<24)))
 #define XV_f30f38(o)	((uint32_t)(0x7ae2c4 + (0x##o<<24)))
 
+/* Convert a legacy SSE opcode with a 0f or f20f prefix to its AVX form. */
+#define XO_TOXV(xo) \
+  ((x86Op)(((xo) & 0xff000000) + (((xo) & 0xff00) ? 0x7be1c4 : 0x78e1c4)))
+
 /* This list of x86 opcodes is not intended to be complete. Opcodes are only
 ** included when needed. Take a look at DynASM or jit.dis_x86 to see the
 ** whole mess.
@@ -240,6 +244,9 @@ typedef enum {
   XV_SARX =	XV_f30f38(f7),
   XV_SHLX =	XV_660f38(f7),
   XV_SHRX =	XV_f20f38(f7),
+  XV_FMADD =	XV_660f38(b9),  /* vfmadd231sd etc. Note: needs VEX_64. */
+  XV_FMSUB =	XV_660f38(bb),
+  XV_FNMADD =	XV_660f38(bd),
 
   /* Variable-length opcodes. XO_* prefix. */
   XO_OR =	XO_(0b),
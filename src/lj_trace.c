@@ -785,7 +785,9 @@ typedef struct ExitDataCP {
   const BCIns *pc;	/* Restart interpreter at this PC. */
 } ExitDataCP;
 
-/* Need to protect lj_snap_restore because it may throw. */
+/* Need to protect lj_snap_restore because it may throw.
+** It can only throw when growing the stack or unsinking allocations.
+*/
 static TValue *trace_exit_cp(lua_State *L, lua_CFunction dummy, void *ud)
 {
   ExitDataCP *exd = (ExitDataCP *)ud;
@@ -843,14 +845,14 @@ int LJ_FASTCALL lj_trace_exit(jit_State *J, void *exptr)
   lua_State *L = J->L;
   ExitState *ex = (ExitState *)exptr;
   ExitDataCP exd;
-  int errcode;
   const BCIns *pc;
   void *cf;
   GCtrace *T;
+  SnapShot *snap;
 #ifdef EXITSTATE_PCREG
   J->parent = trace_exit_find(J, (MCode *)(intptr_t)ex->gpr[EXITSTATE_PCREG]);
 #endif
-  T = traceref(J, J->parent); UNUSED(T);
+  T = traceref(J, J->parent);
 #ifdef EXITSTATE_CHECKEXIT
   if (J->exitno == T->nsnap) {  /* Treat stack check like a parent exit. */
     lj_assertJ(T->root != 0, "stack check in root trace");
@@ -860,11 +862,19 @@ int LJ_FASTCALL lj_trace_exit(jit_State *J, void *exptr)
   }
 #endif
   lj_assertJ(T != NULL && J->exitno < T->nsnap, "bad trace or exit number");
-  exd.J = J;
-  exd.exptr = exptr;
-  errcode = lj_vm_cpcall(L, NULL, &exd, trace_exit_cp);
-  if (errcode)
-    return -errcode;  /* Return negated error code. */
+  snap = &T->snap[J->exitno];
+  if (snap->nexit != ~(uint32_t)0) snap->nexit++;
+  if (!(snap->flags & SNAPFLAG_SUNK) &&
+      L->base + snap->topslot < tvref(L->maxstack)) {
+    exd.pc = lj_snap_restore(J, exptr);  /* Cannot throw. Skip the cpcall. */
+  } else {
+    int errcode;
+    exd.J = J;
+    exd.exptr = exptr;
+    errcode = lj_vm_cpcall(L, NULL, &exd, trace_exit_cp);
+    if (errcode)
+      return -errcode;  /* Return negated error code. */
+  }
 
   if (!(LJ_HASPROFILE && (G(L)->hookmask & HOOK_PROFILE)))
     lj_vmevent_send(L, TEXIT,
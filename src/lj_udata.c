@@ -8,6 +8,7 @@
 
 #include "lj_obj.h"
 #include "lj_gc.h"
+#include "lj_buf.h"
 #include "lj_udata.h"
 
 GCudata *lj_udata_new(lua_State *L, MSize sz, GCtab *env)
@@ -29,6 +30,8 @@ GCudata *lj_udata_new(lua_State *L, MSize sz, GCtab *env)
 
 void LJ_FASTCALL lj_udata_free(global_State *g, GCudata *ud)
 {
+  if (ud->udtype == UDTYPE_BUFFER)
+    lj_buf_free(g, &((SBufExt *)uddata(ud))->sb);
   lj_mem_free(g, ud, sizeudata(ud));
 }
 
@@ -55,6 +55,7 @@
 #include "lj_clib.c"
 #include "lj_cparse.c"
 #include "lj_lib.c"
+#include "lj_serialize.c"
 #include "lj_ir.c"
 #include "lj_opt_mem.c"
 #include "lj_opt_fold.c"
@@ -85,5 +86,6 @@
 #include "lib_bit.c"
 #include "lib_jit.c"
 #include "lib_ffi.c"
+#include "lib_buffer.c"
 #include "lib_init.c"
 